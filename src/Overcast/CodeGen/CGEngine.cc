@@ -1,118 +1,269 @@
 #include "ocpch.h"
 #include "CGEngine.h"
+#include "CGTarget.h"
+#include "llvm/Transforms/Utils/Mem2Reg.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/Transforms/IPO/ThinLTOBitcodeWriter.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Support/xxhash.h"
+#include <filesystem>
+#include <future>
+
+llvm::Module* Overcast::CodeGen::CGEngine::Generate(const Overcast::Semantic::Binder::GlobalSymbolIndex& globalSymbols, const std::vector<std::unique_ptr<Statement>>& statements, const std::unordered_set<std::string>& calledElsewhere)
+{
+	this->calledElsewhere = &calledElsewhere;
+	DeclareGlobals(globalSymbols);
+	GenerateFile(statements);
+	PromoteSlots();
+	this->calledElsewhere = nullptr;
+
+	return this->module.get();
+}
+
+llvm::Module* Overcast::CodeGen::CGEngine::GenerateProgram(const Overcast::Semantic::Binder::GlobalSymbolIndex& globalSymbols, const std::vector<const std::vector<std::unique_ptr<Statement>>*>& files)
+{
+	DeclareGlobals(globalSymbols);
+	// with no other modules around, only main and exported functions can be called from outside (see GenerateFunction)
+	for (const auto* statements : files)
+	{
+		GenerateFile(*statements);
+	}
+
+	PromoteSlots();
+
+	return this->module.get();
+}
 
-llvm::Module* Overcast::CodeGen::CGEngine::Generate(std::unordered_map<std::string, Overcast::Semantic::Binder::Symbol> globalSymbols, const std::vector<std::unique_ptr<Statement>>& statements)
+void Overcast::CodeGen::CGEngine::DeclareGlobals(const Overcast::Semantic::Binder::GlobalSymbolIndex& globalSymbols)
 {
-	// import printf from C
+	// the passes that run before emission want to know the target, so the module gets it up front
+	auto targetMachine = CGTarget::Get().AcquireTargetMachine(options);
+	module->setTargetTriple(CGTarget::Get().GetTriple());
+	module->setDataLayout(targetMachine->createDataLayout());
+
+	// the runtime's printf, print only uses it when the format can't be taken apart at compile time (see GenerateDirectPrint)
 	llvm::FunctionType* printType = llvm::FunctionType::get(
 		llvm::Type::getInt32Ty(context),
 		{ llvm::PointerType::get(llvm::Type::getInt8Ty(context), 0)},
 		true
 	);
 
-	auto* func = llvm::Function::Create(printType, llvm::Function::ExternalLinkage, "printf", this->module.get());
-	symbolTable["func:print"] = func;
+	auto* printFunction = llvm::Function::Create(printType, llvm::Function::ExternalLinkage, "oc_printf", this->module.get());
+	printFunction->addFnAttr(llvm::Attribute::NoUnwind);
 
-	for (const auto& s : globalSymbols)
+	// lay out every struct up front, opaque first so members can name any struct
+	// functions are only declared once something in this module uses them (see GetFunction)
+	for (const auto* s : globalSymbols.GetSymbols())
 	{
-		auto symbol = s.second;
-		if (symbol.Kind == Overcast::Semantic::Binder::SymbolKind::Function)
+		if (s->Kind == Overcast::Semantic::Binder::SymbolKind::Struct)
 		{
-			std::vector<llvm::Type*> parameters;
-
-			for (const auto& param : symbol.ParamTypes)
-			{
-				parameters.push_back(GetLLVMType(*param));
-			}
-
-			llvm::FunctionType* fType = llvm::FunctionType::get(
-				GetLLVMType(*symbol.Type),
-				parameters,
-				false
-			);
-
-			auto* _func = llvm::Function::Create(fType, llvm::Function::ExternalLinkage, "func:" + s.first, this->module.get());
-			symbolTable["func:"+s.first] = _func;
-			typedSymbolTable["func:" + s.first] = { fType->getReturnType() };
-			semanticTypeTable["func:" + s.first] = s.second.Type;
+			structDefTable[s->Name] = { llvm::StructType::create(context, s->Name), {}, s->Type };
 		}
-		else if (symbol.Kind == Overcast::Semantic::Binder::SymbolKind::Struct)
+	}
+
+	for (const auto* s : globalSymbols.GetSymbols())
+	{
+		const auto& symbol = *s;
+		if (symbol.Kind == Overcast::Semantic::Binder::SymbolKind::Struct)
 		{
 			std::vector<llvm::Type*> memberVars;
-			std::map<std::string, StructDef::StructMember> StructMembers;
+			auto& structDef = structDefTable[symbol.Name];
 
-			int idx = 0;
 			for (const auto& var : symbol.StructSymbols)
 			{
 				if (var.Kind == Overcast::Semantic::Binder::SymbolKind::Variable)
 				{
 					memberVars.push_back(GetLLVMType(*var.Type));
-					StructMembers[var.Name] = { memberVars.back(), var.Name, idx++, var.Type };
+					structDef.StructMembers.push_back({ memberVars.back(), var.Name, var.FieldIndex, var.Type });
 				}
 			}
 
-			auto* structType = llvm::StructType::create(memberVars, symbol.Name, false);
-			structDefTable[symbol.Name] = { structType, StructMembers, symbol.Type };
-
-			for (const auto& memFunc : symbol.StructSymbols)
-			{
-				if (memFunc.Kind == Overcast::Semantic::Binder::SymbolKind::Function)
-				{
-					std::vector<llvm::Type*> parameters;
-
-					for (const auto& param : memFunc.ParamTypes)
-					{
-						parameters.push_back(GetLLVMType(*param));
-					}
-
-					llvm::FunctionType* fType = llvm::FunctionType::get(
-						GetLLVMType(*memFunc.Type),
-						parameters,
-						false
-					);
-
-					auto* _func = llvm::Function::Create(fType, llvm::Function::ExternalLinkage, symbol.Name + "::" + memFunc.Name, this->module.get());
-					symbolTable[symbol.Name + "::" + memFunc.Name] = _func;
-					typedSymbolTable[symbol.Name + "::" + memFunc.Name] = { fType->getReturnType() };
-					semanticTypeTable[symbol.Name + "::" + memFunc.Name] = memFunc.Type;
-				}
-			}
+			structDef.StructType->setBody(memberVars, false);
 		}
 	}
+}
 
+void Overcast::CodeGen::CGEngine::GenerateFile(const std::vector<std::unique_ptr<Statement>>& statements)
+{
 	for (auto& statement : statements)
 	{
 		GenerateStatement(*statement);
 	}
+}
 
-	return this->module.get();
+std::optional<Overcast::CodeGen::OptLevel> Overcast::CodeGen::ParseOptLevel(std::string level)
+{
+	if (!level.empty() && level[0] == '-')
+		level.erase(0, 1);
+	if (!level.empty() && (level[0] == 'O' || level[0] == 'o'))
+		level.erase(0, 1);
+
+	if (level == "0") return OptLevel::O0;
+	if (level == "1") return OptLevel::O1;
+	if (level == "2") return OptLevel::O2;
+	if (level == "3") return OptLevel::O3;
+	if (level == "s") return OptLevel::Os;
+	if (level == "z") return OptLevel::Oz;
+	return std::nullopt;
+}
+
+std::optional<Overcast::CodeGen::LTOMode> Overcast::CodeGen::ParseLTOMode(const std::string& mode)
+{
+	if (mode.empty() || mode == "none")
+		return LTOMode::None;
+	if (mode == "thin")
+		return LTOMode::Thin;
+	return std::nullopt;
+}
+
+void Overcast::CodeGen::ResolveHostTarget(CodeGenOptions& options)
+{
+	if (options.CPU != "native")
+		return;
+
+	options.CPU = llvm::sys::getHostCPUName().str();
+
+	std::string hostFeatures;
+	llvm::StringMap<bool> features;
+	if (llvm::sys::getHostCPUFeatures(features))
+	{
+		for (const auto& feature : features)
+		{
+			if (!hostFeatures.empty())
+				hostFeatures += ",";
+			hostFeatures += (feature.second ? "+" : "-") + feature.first().str();
+		}
+	}
+
+	// the last mention of a feature wins, so the explicit ones go after the host's
+	if (options.Features.empty())
+		options.Features = hostFeatures;
+	else if (!hostFeatures.empty())
+		options.Features = hostFeatures + "," + options.Features;
 }
 
 void Overcast::CodeGen::CGEngine::EmitToObjectFile(const std::string& outputFile, llvm::Module* module)
 {
-	llvm::InitializeAllTargets();
-	llvm::InitializeAllTargetMCs();
-	llvm::InitializeAllAsmParsers();
-	llvm::InitializeAllAsmPrinters();
+	size_t definedFunctions = 0;
+	for (const auto& function : *module)
+	{
+		if (!function.isDeclaration())
+			definedFunctions++;
+	}
+
+	// the linker takes every object in obj/, so whatever the last build left that this one won't overwrite has to go
+	// thin lto objects are only bitcode, the linker already runs their backends in parallel
+	size_t parts = options.LTO == LTOMode::Thin ? 1 : std::min<size_t>(options.SplitParts, definedFunctions);
+	if (parts <= 1)
+	{
+		RemoveObjectFile(outputFile);
+		EmitModule(*module, outputFile, options);
+		return;
+	}
+
+	RemoveObjectFile(outputFile);
+
+	// the parts share this module's context and only one thread can use a context,
+	// so each one goes through bitcode and gets parsed back into a context of its own
+	// locals are free to go to any part, the split exports them (hidden) to the parts that use them,
+	// keeping them with their users would pull every internal function and pooled string into main's part
+	MakeLocalsUnique(*module, outputFile);
+	std::vector<llvm::SmallString<0>> partBitcode;
+	llvm::SplitModule(*module, static_cast<unsigned>(parts), [&partBitcode](std::unique_ptr<llvm::Module> part) {
+		partBitcode.emplace_back();
+		llvm::raw_svector_ostream out(partBitcode.back());
+		llvm::WriteBitcodeToFile(*part, out);
+		}, false);
+
+	const std::string moduleName = module->getModuleIdentifier();
+	auto emitPart = [this, &partBitcode, &outputFile, &moduleName](size_t i) {
+		llvm::LLVMContext partContext;
+		llvm::MemoryBufferRef buffer(llvm::StringRef(partBitcode[i].data(), partBitcode[i].size()), moduleName);
+		auto part = llvm::parseBitcodeFile(buffer, partContext);
+		if (!part)
+		{
+			throw std::runtime_error("Could not reload part " + std::to_string(i) + " of " + moduleName + ": " + llvm::toString(part.takeError()));
+		}
+
+		EmitModule(**part, GetPartPath(outputFile, i), options);
+	};
+
+	std::vector<std::future<void>> futures;
+	for (size_t i = 1; i < partBitcode.size(); i++)
+	{
+		futures.push_back(std::async(std::launch::async, emitPart, i));
+	}
+
+	// every part references partBitcode, so they all have to finish before anything's thrown
+	std::exception_ptr firstError;
+	try
+	{
+		emitPart(0);
+	}
+	catch (...)
+	{
+		firstError = std::current_exception();
+	}
+
+	for (auto& future : futures)
+	{
+		try
+		{
+			future.get();
+		}
+		catch (...)
+		{
+			if (!firstError)
+				firstError = std::current_exception();
+		}
+	}
 
-	auto TargetTriple = llvm::sys::getDefaultTargetTriple();
-	module->setTargetTriple(TargetTriple);
+	if (firstError)
+		std::rethrow_exception(firstError);
+}
 
-	std::string Error;
-	auto Target = llvm::TargetRegistry::lookupTarget(TargetTriple, Error);
+void Overcast::CodeGen::CGEngine::RemoveObjectFile(const std::string& outputFile)
+{
+	std::filesystem::remove(outputFile);
+	for (size_t i = 0; std::filesystem::remove(GetPartPath(outputFile, i)); i++);
+}
 
-	auto CPU = "generic";
-	auto Features = "";
+void Overcast::CodeGen::CGEngine::MakeLocalsUnique(llvm::Module& module, const std::string& outputFile)
+{
+	// every file has its own const:X and .str, once exported those would clash with another file's at link time
+	const std::string prefix = "oc." + llvm::utohexstr(llvm::xxHash64(outputFile)) + ".";
+	for (auto& value : module.global_values())
+	{
+		if (value.hasLocalLinkage() && !value.isDeclaration())
+			value.setName(prefix + (value.hasName() ? value.getName().str() : "anon"));
+	}
+}
 
-	llvm::TargetOptions opt;
-	auto RM = std::optional<llvm::Reloc::Model>();
-	auto TargetMachine = Target->createTargetMachine(TargetTriple, CPU, Features, opt, RM);
+std::string Overcast::CodeGen::CGEngine::GetPartPath(const std::string& outputFile, size_t part)
+{
+	std::filesystem::path path(outputFile);
+	path.replace_extension(".part" + std::to_string(part) + path.extension().string());
+	return path.string();
+}
 
-	module->setDataLayout(TargetMachine->createDataLayout());
+void Overcast::CodeGen::CGEngine::EmitModule(llvm::Module& module, const std::string& outputFile, const CodeGenOptions& options)
+{
+	auto targetMachine = CGTarget::Get().AcquireTargetMachine(options);
+
+	llvm::OptimizationLevel passLevel = llvm::OptimizationLevel::O2;
+	switch (options.Level)
+	{
+	case OptLevel::O0: passLevel = llvm::OptimizationLevel::O0; break;
+	case OptLevel::O1: passLevel = llvm::OptimizationLevel::O1; break;
+	case OptLevel::O2: passLevel = llvm::OptimizationLevel::O2; break;
+	case OptLevel::O3: passLevel = llvm::OptimizationLevel::O3; break;
+	case OptLevel::Os: passLevel = llvm::OptimizationLevel::Os; break;
+	case OptLevel::Oz: passLevel = llvm::OptimizationLevel::Oz; break;
+	}
 
 	llvm::legacy::PassManager pass;
 
-	llvm::PassBuilder passBuilder;
+	llvm::PassBuilder passBuilder(targetMachine.get());
 	llvm::LoopAnalysisManager loopAM;
 	llvm::FunctionAnalysisManager functionAM;
 	llvm::CGSCCAnalysisManager cgsccAM;
@@ -124,21 +275,41 @@ void Overcast::CodeGen::CGEngine::EmitToObjectFile(const std::string& outputFile
 	passBuilder.registerLoopAnalyses(loopAM);
 	passBuilder.crossRegisterProxies(loopAM, functionAM, cgsccAM, moduleAM);
 
-	llvm::ModulePassManager modulePM = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
+	std::error_code EC;
+	llvm::raw_fd_ostream dest(outputFile, EC, llvm::sys::fs::OF_None);
+	if (EC)
+	{
+		throw std::runtime_error("Could not open " + outputFile + " (" + EC.message() + ")");
+	}
+
+	// O0 has its own pipeline, the default one refuses to build without optimizing
+	// for thin lto only the pre-link half runs here, the linker does the rest once it can see every module
+	llvm::ModulePassManager modulePM;
+	if (options.Level == OptLevel::O0)
+		modulePM = passBuilder.buildO0DefaultPipeline(passLevel, options.LTO == LTOMode::Thin);
+	else if (options.LTO == LTOMode::Thin)
+		modulePM = passBuilder.buildThinLTOPreLinkDefaultPipeline(passLevel);
+	else
+		modulePM = passBuilder.buildPerModuleDefaultPipeline(passLevel);
 
-	//module->print(llvm::errs(), nullptr);
+	if (options.LTO == LTOMode::Thin)
+	{
+		modulePM.addPass(llvm::ThinLTOBitcodeWriterPass(dest, nullptr));
+		modulePM.run(module, moduleAM);
+		dest.flush();
+		return;
+	}
 
-	modulePM.run(*module, moduleAM);
+	//module.print(llvm::errs(), nullptr);
 
-	std::error_code EC;
-	llvm::raw_fd_ostream dest(outputFile, EC, llvm::sys::fs::OF_None);
+	modulePM.run(module, moduleAM);
 
-	if (TargetMachine->addPassesToEmitFile(pass, dest, nullptr, llvm::CodeGenFileType::ObjectFile)) {
+	if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, llvm::CodeGenFileType::ObjectFile)) {
 		llvm::errs() << "TargetMachine can't emit a file of this type\n";
 		return;
 	}
 
-	pass.run(*module);
+	pass.run(module);
 	dest.flush();
 }
 
@@ -169,6 +340,10 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateStatement(Statement& statement
 	{
 		return GenerateVarSet(*varSet);
 	}
+	else if (auto compound = dynamic_cast<CompoundAssignmentStatement*>(&statement))
+	{
+		return GenerateCompoundAssignment(*compound);
+	}
 	else if (auto ifStmt = dynamic_cast<IfStatement*>(&statement))
 	{
 		return GenerateIfStatement(*ifStmt);
@@ -177,9 +352,14 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateStatement(Statement& statement
 	{
 		return GenerateWhileStatement(*whStmt);
 	}
-	else if (auto constDecl = dynamic_cast<ConstDeclStatement*>(&statement))
+	else if (auto forStmt = dynamic_cast<ForStatement*>(&statement))
+	{
+		return GenerateForStatement(*forStmt);
+	}
+	else if (dynamic_cast<ConstDeclStatement*>(&statement))
 	{
-		throw std::runtime_error("Const declarations are not supported yet.");
+		// nothing to emit, the binder folded every use into a constant
+		return nullptr;
 	}
 	else if (dynamic_cast<UseStatement*>(&statement))
 	{
@@ -197,61 +377,83 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateStatement(Statement& statement
 
 llvm::Value* Overcast::CodeGen::CGEngine::GenerateFunction(const FunctionDeclStatement& funcDecl)
 {
-	llvm::Function* function = nullptr;
-	llvm::Type* returnType = nullptr;
+	llvm::Function* function = GetFunction(*funcDecl.ResolvedSymbol);
+	llvm::Type* returnType = function->getReturnType();
 
-	if (symbolTable.find("func:"+funcDecl.FuncName) == symbolTable.end())
+	if (funcDecl.IsExtern)
 	{
-		std::vector<llvm::Type*> paramTypes;
-		for (auto& param : funcDecl.Parameters)
-		{
-			paramTypes.push_back(GetLLVMType(*param.ParameterType));
-		}
-
-		returnType = GetLLVMType(*funcDecl.ReturnType);
-		llvm::FunctionType* funcType = llvm::FunctionType::get(returnType, paramTypes, false);
-		function = llvm::Function::Create(funcType, llvm::Function::ExternalLinkage, funcDecl.FuncName == "main" ? "main" : funcDecl.IsExtern ? funcDecl.FuncName : "func:" + funcDecl.FuncName, module.get());
-
-		if (funcDecl.IsExtern)
-		{
-			symbolTable.insert({ funcDecl.FuncName == "main" ? "main" : funcDecl.FuncName, function });
-			function->setLinkage(llvm::Function::ExternalLinkage); // just to make sure
-			return function;
-		}
+		function->setLinkage(llvm::Function::ExternalLinkage); // just to make sure
+		return function;
 	}
-	else
+
+	// other modules only get to see exported functions, main, and what they call, the optimizer can inline, specialize or drop the rest
+	const auto& linkName = funcDecl.ResolvedSymbol->LinkName;
+	bool visibleOutside = funcDecl.IsExported || linkName == "main" || (calledElsewhere && calledElsewhere->count(linkName));
+	if (!visibleOutside)
+		function->setLinkage(llvm::GlobalValue::InternalLinkage);
+
+	// what the binder proved about the body, any call counts as reading and writing everything
+	const auto& inferred = funcDecl.Inferred;
+	if (!inferred.CallsFunctions && !inferred.WritesMemory)
+		function->setMemoryEffects(inferred.ReadsMemory ? llvm::MemoryEffects::readOnly() : llvm::MemoryEffects::none());
+	if (!inferred.CallsFunctions)
+		function->addFnAttr(llvm::Attribute::NoRecurse);
+	if (!inferred.CallsFunctions && !inferred.CallsBuiltins && !inferred.HasLoops)
+		function->addFnAttr(llvm::Attribute::WillReturn);
+	for (unsigned i = 0; i < inferred.NoAliasParams.size() && i < function->arg_size(); i++)
 	{
-		function = llvm::dyn_cast<llvm::Function>(symbolTable["func:" + funcDecl.FuncName]);
-		returnType = typedSymbolTable["func:" + funcDecl.FuncName].type;
+		if (inferred.NoAliasParams[i])
+			function->addParamAttr(i, llvm::Attribute::NoAlias);
 	}
 
-	for (auto& arg : function->args()) {
-		arg.setName(funcDecl.Parameters[arg.getArgNo()].ParameterName);
-		symbolTable[arg.getName().str()] = &arg;
-		typedSymbolTable[arg.getName().str()] = { arg.getType() };
-		auto it = std::find_if(funcDecl.Parameters.begin(), funcDecl.Parameters.end(), [&](const Parameter& param) {
-			return param.ParameterName == arg.getName().str();
-			});
-		semanticTypeTable[arg.getName().str()] = it->ParameterType.get();
-	}
+	if (funcDecl.FindAttribute("inline"))
+		function->addFnAttr(llvm::Attribute::AlwaysInline);
+	else if (funcDecl.FindAttribute("noinline"))
+		function->addFnAttr(llvm::Attribute::NoInline);
+
+	// the pass pipeline reads these off each function when deciding how hard to go and which instructions it has
+	function->addFnAttr("target-cpu", options.CPU);
+	if (!options.Features.empty())
+		function->addFnAttr("target-features", options.Features);
+	if (options.Level == OptLevel::Os || options.Level == OptLevel::Oz)
+		function->addFnAttr(llvm::Attribute::OptimizeForSize);
+	if (options.Level == OptLevel::Oz)
+		function->addFnAttr(llvm::Attribute::MinSize);
 
 	llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(context, "entry", function);
 	builder.SetInsertPoint(entryBlock);
 
 	currentFunction = function;
+	freeSlots.clear();
+
+	for (auto& arg : function->args()) {
+		const auto& param = funcDecl.Parameters[arg.getArgNo()];
+		arg.setName(param.ParameterName);
+
+		if (arg.getType()->isPointerTy() || arg.getType()->isStructTy()) // objects are used through their pointer as is
+		{
+			valueTable[param.ResolvedSymbol] = { &arg, arg.getType(), false };
+			continue;
+		}
+
+		// scalars get a slot like any var so they can be assigned, mem2reg turns it back into the argument
+		auto* argSlot = CreateEntryBlockAlloca(arg.getType(), "arg:" + param.ParameterName);
+		builder.CreateStore(&arg, argSlot);
+		valueTable[param.ResolvedSymbol] = { argSlot, arg.getType(), true };
+	}
+
+	EnterSlotScope();
 	for (auto& stmt : funcDecl.Body)
 	{
 		GenerateStatement(*stmt);
 	}
+	ExitSlotScope();
 
 	if (returnType->isVoidTy())
 	{
 		builder.CreateRetVoid();
 	}
 
-	symbolTable.insert({ funcDecl.FuncName == "main" ? "main" : "func:" + funcDecl.FuncName, function });
-	semanticTypeTable["func:"+funcDecl.FuncName] = funcDecl.ReturnType.get();
-
 	currentFunction = nullptr;
 
 	return function;
@@ -265,99 +467,67 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateReturn(const ReturnStatement&
 
 llvm::Value* Overcast::CodeGen::CGEngine::GenerateStructDecl(const StructDeclStatement& strDecl)
 {
-	// okay, first make the struct type
-	std::vector<llvm::Type*> memberTypes;
-	std::map<std::string, StructDef::StructMember> StructMembers;
-
-	int idx = 0;
-	for (const auto& member : strDecl.Members)
+	// okay, first make the struct type (unless the global symbols already laid it out)
+	if (structDefTable.find(strDecl.StructName) == structDefTable.end())
 	{
-		auto* type = GetLLVMType(*member.ParameterType);
-		auto name = member.ParameterName;
+		std::vector<llvm::Type*> memberTypes;
+		std::vector<StructDef::StructMember> StructMembers;
 
-		memberTypes.push_back(type);
-		StructMembers.insert({ name, {type, name, idx++, member.ParameterType.get() }});
-	}
+		int idx = 0;
+		for (const auto& member : strDecl.Members)
+		{
+			auto* type = GetLLVMType(*member.ParameterType);
 
-	auto* structType = llvm::StructType::create(module->getContext(), strDecl.StructName);
-	structType->setBody(memberTypes, false);
-	structDefTable.insert({ strDecl.StructName, { structType, StructMembers, &IdentifierType(strDecl.StructName) } });
+			memberTypes.push_back(type);
+			StructMembers.push_back({ type, member.ParameterName, idx++, member.ParameterType.get() });
+		}
+
+		auto* structType = llvm::StructType::create(module->getContext(), strDecl.StructName);
+		structType->setBody(memberTypes, false);
+		structDefTable.insert({ strDecl.StructName, { structType, StructMembers, new IdentifierType(strDecl.StructName) } });
+	}
 
 	// then the ~member functions~
 	for (auto& fDecl : strDecl.MemberFunctions) {
-		fDecl->FuncName = strDecl.StructName + "::" + fDecl->FuncName;
-		semanticTypeTable[fDecl->FuncName] = fDecl->ReturnType.get();
 		GenerateFunction(*fDecl);
 	}
 
 	return nullptr;
 }
 
-llvm::AllocaInst* CreateEntryBlockAlloca(llvm::Function* func, llvm::Type* type, const std::string& varName) { // helper
-	llvm::IRBuilder<> tmpBuilder(&func->getEntryBlock(), func->getEntryBlock().begin());
-	return tmpBuilder.CreateAlloca(type, nullptr, varName);
+llvm::AllocaInst* Overcast::CodeGen::CGEngine::CreateEntryBlockAlloca(llvm::Type* type, const std::string& name)
+{
+	// every alloca goes at the top of the entry block, that's what mem2reg/SROA look at
+	llvm::IRBuilder<> tmpBuilder(&currentFunction->getEntryBlock(), currentFunction->getEntryBlock().begin());
+	return tmpBuilder.CreateAlloca(type, nullptr, name);
 }
 
-llvm::Value* Overcast::CodeGen::CGEngine::GenerateVarDecl(const VariableDeclStatement& varDecl) // because this can be in a loop, we need a condition
+llvm::Value* Overcast::CodeGen::CGEngine::GenerateVarDecl(const VariableDeclStatement& varDecl)
 {
-	if (symbolTable.find(varDecl.VarName) == symbolTable.end())
-	{
-		auto* varType = GetLLVMType(*varDecl.VariableType);
-		llvm::AllocaInst* varAlloca = nullptr;
-
-		if (varDecl.Defined && varDecl.DefaultValue)
-		{
-			if (!dynamic_cast<StructCtorExpr*>(varDecl.DefaultValue.get()))
-			{
-				varAlloca = CreateEntryBlockAlloca(currentFunction, varType, "var:" + varDecl.VarName);
-				CGResult initValue = GenerateExpression(*varDecl.DefaultValue.get());
-				builder.CreateStore(initValue.value, varAlloca);
-			}
-			else
-			{
-				CGResult initValue = GenerateExpression(*varDecl.DefaultValue.get());
-				varAlloca = llvm::dyn_cast<llvm::AllocaInst>(initValue.value);
-			}
-		}
+	auto* varType = GetLLVMType(*varDecl.VariableType);
 
-		symbolTable[varDecl.VarName] = varAlloca;
-		typedSymbolTable[varDecl.VarName] = { varType };
-		semanticTypeTable[varDecl.VarName] = { varDecl.VariableType.get() };
-		return varAlloca;
-	}
-	else // it's already 'defined' just scoping rules make it valid
+	if (varDecl.Defined && varDecl.DefaultValue && dynamic_cast<StructCtorExpr*>(varDecl.DefaultValue.get()))
 	{
-		auto varAlloca = symbolTable[varDecl.VarName];
-		auto type = GetLLVMType(*varDecl.VariableType);
-		CGResult initValue;
-		// just store it
-		if (varDecl.Defined && varDecl.DefaultValue)
-		{
-			if (!dynamic_cast<StructCtorExpr*>(varDecl.DefaultValue.get()))
-			{
-				initValue = GenerateExpression(*varDecl.DefaultValue.get());
-				builder.CreateStore(initValue.value, varAlloca);
-			}
-			else
-			{
-				initValue = GenerateExpression(*varDecl.DefaultValue.get());
-				varAlloca = llvm::dyn_cast<llvm::AllocaInst>(initValue.value);
-			}
-		}
-
-		// update the data, just in case
-		symbolTable[varDecl.VarName] = varAlloca;
-		typedSymbolTable[varDecl.VarName] = { type };
-		semanticTypeTable[varDecl.VarName] = { varDecl.VariableType.get() };
+		// the struct object itself is the variable (on the stack or the heap, escape analysis picked)
+		CGResult initValue = GenerateExpression(*varDecl.DefaultValue.get());
+		valueTable[varDecl.ResolvedSymbol] = { initValue.value, varType, false };
+		return initValue.value;
+	}
 
-		if (phiTable.find(varDecl.VarName) != phiTable.end())
-		{
-			auto phiNode = phiTable[varDecl.VarName];
-			phiNode->addIncoming(initValue.value, builder.GetInsertBlock());
-		}
+	llvm::Value* initValue = nullptr;
+	if (varDecl.Defined && varDecl.DefaultValue)
+	{
+		initValue = GenerateExpression(*varDecl.DefaultValue.get()).value;
+	}
 
-		return varAlloca;
+	auto* varSlot = CreateScopedSlot(varType, "var:" + varDecl.VarName);
+	if (initValue)
+	{
+		builder.CreateStore(initValue, varSlot);
 	}
+
+	valueTable[varDecl.ResolvedSymbol] = { varSlot, varType, true };
+	return varSlot;
 }
 
 #pragma optimize("", off)
@@ -374,22 +544,12 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateVarSet(const AssignmentStateme
 
 	if (auto ctorExpr = dynamic_cast<StructCtorExpr*>(assign.Value.get()))
 	{
-		if (inst.value->getName().starts_with_insensitive(".gep"))
-		{
-			auto value = GenerateStructCtor(ctorExpr, inst.value);
-		}
+		// construct straight into the assigned storage
+		GenerateStructCtor(ctorExpr, inst.value);
 	}
 	else
 	{
 		auto value = GenerateExpression(*assign.Value);
-		if (auto varExpr = dynamic_cast<const VariableUseExpr*>(assign.LHS.get()))
-		{
-			if (phiTable.find(varExpr->VariableName) != phiTable.end())
-			{
-				auto phiNode = phiTable[varExpr->VariableName];
-				phiNode->addIncoming(value.value, builder.GetInsertBlock());
-			}
-		}
 		builder.CreateStore(value.value, inst.value);
 	}
 
@@ -397,6 +557,25 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateVarSet(const AssignmentStateme
 }
 #pragma optimize("", on)
 
+llvm::Value* Overcast::CodeGen::CGEngine::GenerateCompoundAssignment(const CompoundAssignmentStatement& assign)
+{
+	// the address (slot or gep) is only generated once, the load and the store both go through it
+	bool prevPointerState = RequestPointerAccess;
+	RequestPointerAccess = true;
+	auto target = GenerateExpression(*assign.LHS);
+	RequestPointerAccess = prevPointerState;
+	if (!target.value)
+	{
+		throw std::runtime_error("Variable not found in symbol table.");
+	}
+
+	auto current = builder.CreateLoad(target.type, target.value, ".compoundLoad");
+	auto value = GenerateExpression(*assign.Value);
+	builder.CreateStore(GenerateBinaryOp(assign.Operator, current, value.value), target.value);
+
+	return target.value;
+}
+
 llvm::Value* Overcast::CodeGen::CGEngine::GenerateIfStatement(
 	const IfStatement& ifStmt,
 	llvm::BasicBlock* mergeBlock)
@@ -426,6 +605,7 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateIfStatement(
 	}
 
 	builder.SetInsertPoint(thenBlock);
+	EnterSlotScope();
 	for (auto& stmt : ifStmt.Body) {
 		if (auto* nestedIf = dynamic_cast<IfStatement*>(stmt.get())) {
 			GenerateIfStatement(*nestedIf, mergeBlock);
@@ -434,12 +614,14 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateIfStatement(
 			GenerateStatement(*stmt);
 		}
 	}
+	ExitSlotScope();
 	if (!builder.GetInsertBlock()->getTerminator()) {
 		builder.CreateBr(mergeBlock);
 	}
 
 	if (hasElse) {
 		builder.SetInsertPoint(elseBlock);
+		EnterSlotScope();
 		for (auto& stmt : ifStmt.ElseBody) {
 			if (auto* nestedIf = dynamic_cast<IfStatement*>(stmt.get())) {
 				GenerateIfStatement(*nestedIf, mergeBlock);
@@ -448,6 +630,7 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateIfStatement(
 				GenerateStatement(*stmt);
 			}
 		}
+		ExitSlotScope();
 		if (!builder.GetInsertBlock()->getTerminator()) {
 			builder.CreateBr(mergeBlock);
 		}
@@ -458,120 +641,198 @@ llvm::Value* Overcast::CodeGen::CGEngine::GenerateIfStatement(
 	return nullptr;
 }
 
-std::string Overcast::CodeGen::CGEngine::AnalyzeExpression(Expression& expression)
+llvm::Value* Overcast::CodeGen::CGEngine::GenerateWhileStatement(const WhileStatement& whStmt)
+{
+	return GenerateLoop(whStmt, whStmt.Condition.get(), whStmt.Body, nullptr);
+}
+
+llvm::Value* Overcast::CodeGen::CGEngine::GenerateForStatement(const ForStatement& forStmt)
 {
-	if (auto varExpr = dynamic_cast<const VariableUseExpr*>(&expression))
+	// the loop var's slot lives from here to the end of the loop
+	EnterSlotScope();
+	if (forStmt.Init)
+		GenerateStatement(*forStmt.Init);
+
+	auto* exitBlock = GenerateLoop(forStmt, forStmt.Condition.get(), forStmt.Body, forStmt.Step.get());
+	ExitSlotScope();
+
+	return exitBlock;
+}
+
+llvm::BasicBlock* Overcast::CodeGen::CGEngine::GenerateLoop(const Statement& loopStmt, Expression* condition, const std::vector<std::unique_ptr<Statement>>& body, Statement* step)
+{
+	// the shape the loop passes expect: the current block is the preheader, the header is the only block that tests
+	// the condition, and there's one latch with the only backedge, which is where the llvm.loop metadata goes
+	llvm::Function* function = builder.GetInsertBlock()->getParent();
+
+	auto headerBlock = llvm::BasicBlock::Create(context, "loop.header", function);
+	auto bodyBlock = llvm::BasicBlock::Create(context, "loop.body", function);
+	auto latchBlock = llvm::BasicBlock::Create(context, "loop.latch", function);
+	auto exitBlock = llvm::BasicBlock::Create(context, "loop.exit", function);
+
+	builder.CreateBr(headerBlock);
+
+	// vars that change in the loop stay in their slots here, PromoteSlots makes the phis afterwards
+	builder.SetInsertPoint(headerBlock);
+	if (condition)
+	{
+		llvm::Value* conditionValue = GenerateExpression(*condition).value;
+		if (!conditionValue->getType()->isIntegerTy(1))
+			throw std::runtime_error("Loop condition must be of type bool.");
+
+		builder.CreateCondBr(conditionValue, bodyBlock, exitBlock);
+	}
+	else
+	{
+		builder.CreateBr(bodyBlock);
+	}
+
+	builder.SetInsertPoint(bodyBlock);
+	EnterSlotScope();
+	for (const auto& stmt : body)
 	{
-		return varExpr->VariableName;
+		GenerateStatement(*stmt);
 	}
+	ExitSlotScope(); // every iteration ends the objects it made
 
-	return "<NO>";
+	if (!builder.GetInsertBlock()->getTerminator())
+		builder.CreateBr(latchBlock);
+
+	builder.SetInsertPoint(latchBlock);
+	if (step)
+		GenerateStatement(*step);
+
+	auto* backedge = builder.CreateBr(headerBlock);
+	if (auto* loopID = GetLoopMetadata(loopStmt))
+		backedge->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+
+	builder.SetInsertPoint(exitBlock);
+
+	return exitBlock;
 }
 
-std::vector<Overcast::CodeGen::PhiVariable> Overcast::CodeGen::CGEngine::AnalyzePHIVariables(const std::vector<std::unique_ptr<Statement>>& statements)
+llvm::MDNode* Overcast::CodeGen::CGEngine::GetLoopMetadata(const Statement& loopStmt)
 {
-	std::vector<PhiVariable> phiVariables;
-	for (const auto& stmt : statements)
+	// the binder already checked the arguments, 1 means off for both
+	std::vector<llvm::Metadata*> properties = { nullptr }; // the first operand is the node itself
+	auto addProperty = [&](const char* name, llvm::Constant* value)
 	{
-		if (auto varDeclStatement = dynamic_cast<const VariableDeclStatement*>(stmt.get()))
-		{
-			std::cout << "hi" << std::endl;
-			if (symbolTable.find(varDeclStatement->VarName) != symbolTable.end())
-			{
-				PhiVariable var;
-				var.value = symbolTable[varDeclStatement->VarName];
-				var.type = typedSymbolTable[varDeclStatement->VarName].type;
-				var.name = varDeclStatement->VarName;
-
-				phiVariables.push_back(var);
-			}
-		}
-		else if (auto assignStmt = dynamic_cast<const AssignmentStatement*>(stmt.get()))
-		{
-			std::cout << "hi" << std::endl;
-			PhiVariable var;
-			var.name = AnalyzeExpression(*assignStmt->LHS);
-			if (var.name == "<NO>")
-				continue;
+		properties.push_back(llvm::MDNode::get(context, { llvm::MDString::get(context, name), llvm::ConstantAsMetadata::get(value) }));
+	};
 
-			var.value = symbolTable[var.name];
-			var.type = typedSymbolTable[var.name].type;
+	if (auto vectorize = loopStmt.FindAttribute("vectorize"))
+	{
+		auto width = vectorize->Arguments[0];
+		addProperty("llvm.loop.vectorize.enable", builder.getInt1(width > 1));
+		addProperty("llvm.loop.vectorize.width", builder.getInt32(static_cast<uint32_t>(width)));
+	}
 
-			phiVariables.push_back(var);
-		}
+	if (auto unroll = loopStmt.FindAttribute("unroll"))
+	{
+		auto count = unroll->Arguments[0];
+		if (count == 1)
+			properties.push_back(llvm::MDNode::get(context, { llvm::MDString::get(context, "llvm.loop.unroll.disable") }));
+		else
+			addProperty("llvm.loop.unroll.count", builder.getInt32(static_cast<uint32_t>(count)));
 	}
 
-	return phiVariables;
+	if (properties.size() == 1)
+		return nullptr;
+
+	auto* loopID = llvm::MDNode::getDistinct(context, properties);
+	loopID->replaceOperandWith(0, loopID);
+	return loopID;
 }
 
-llvm::Value* Overcast::CodeGen::CGEngine::GenerateWhileStatement(const WhileStatement& whStmt, llvm::BasicBlock* exitTarget)
+const Overcast::CodeGen::StructDef& Overcast::CodeGen::CGEngine::GetStructDef(const Overcast::Semantic::Binder::Symbol& structSymbol)
 {
-	llvm::Function* function = builder.GetInsertBlock()->getParent();
+	auto it = structDefsBySymbol.find(&structSymbol);
+	if (it != structDefsBySymbol.end())
+		return *it->second;
 
-	auto condBlock = llvm::BasicBlock::Create(context, "conditionBlock", function);
-	auto loopBlock = llvm::BasicBlock::Create(context, "loopBlock", function);
-	auto mergeBlock = llvm::BasicBlock::Create(context, "whileCont", function);
+	auto defIt = structDefTable.find(structSymbol.Name);
+	if (defIt == structDefTable.end())
+		throw std::runtime_error("Struct " + structSymbol.Name + " has not been laid out.");
 
-	builder.CreateBr(condBlock);
+	structDefsBySymbol.insert({ &structSymbol, &defIt->second });
+	return defIt->second;
+}
 
-	// Condition Block
-	builder.SetInsertPoint(condBlock);
-	auto phiVarList = AnalyzePHIVariables(whStmt.Body);
-	auto oldPHITable = phiTable;
-	for (auto& phiVar : phiVarList)
-	{
-		auto phiNode = builder.CreatePHI(phiVar.type, 2, phiVar.name + "_phi");
-		phiNode->addIncoming(builder.CreateLoad(phiVar.type, phiVar.value, "loadInitial"), builder.GetInsertBlock());
-		phiTable[phiVar.name] = phiNode;
-	}
+llvm::GlobalVariable* Overcast::CodeGen::CGEngine::GetConstGlobal(const Overcast::Semantic::Binder::Symbol& constSymbol)
+{
+	auto it = constGlobalTable.find(&constSymbol);
+	if (it != constGlobalTable.end())
+		return it->second;
 
-	llvm::Value* condition = GenerateExpression(*whStmt.Condition.get()).value;
-	if (!condition->getType()->isIntegerTy(1))
-		throw std::runtime_error("Condition in while statement must be of type bool.");
+	auto* initializer = GetConstant(*constSymbol.ConstObject, *constSymbol.Type);
+	auto* global = new llvm::GlobalVariable(*module, initializer->getType(), true, llvm::GlobalValue::PrivateLinkage, initializer, "const:" + constSymbol.Name);
 
-	builder.CreateCondBr(condition, loopBlock, mergeBlock);
+	constGlobalTable.insert({ &constSymbol, global });
+	return global;
+}
+
+llvm::GlobalVariable* Overcast::CodeGen::CGEngine::GetStringConstant(const std::string& value)
+{
+	auto it = stringPool.find(value);
+	if (it != stringPool.end())
+		return it->second;
+
+	// unnamed_addr null terminated constants get put in a mergeable string section, so the linker folds them across objects too
+	auto* initializer = llvm::ConstantDataArray::getString(context, value, true);
+	auto* global = new llvm::GlobalVariable(*module, initializer->getType(), true, llvm::GlobalValue::PrivateLinkage, initializer, ".str");
+	global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+	global->setAlignment(llvm::Align(1));
+
+	stringPool.insert({ value, global });
+	return global;
+}
 
-	// Loop Block
-	builder.SetInsertPoint(loopBlock);
-	for (const auto& stmt : whStmt.Body)
+llvm::Constant* Overcast::CodeGen::CGEngine::GetConstant(const Overcast::Semantic::ConstValue& value, OCType& type)
+{
+	auto* llvmType = GetLLVMType(type);
+	if (auto* structType = llvm::dyn_cast<llvm::StructType>(llvmType))
 	{
-		if (auto whileStmt = dynamic_cast<const WhileStatement*>(stmt.get()))
-		{
-			auto nestedMerge = llvm::dyn_cast<llvm::BasicBlock>(GenerateWhileStatement(*whileStmt, condBlock));
-			builder.SetInsertPoint(nestedMerge);
-		}
-		else
+		if (!value.Fields)
+			return llvm::Constant::getNullValue(structType);
+
+		const auto& structDef = structDefTable.at(type.to_string());
+		std::vector<llvm::Constant*> fields;
+		for (const auto& member : structDef.StructMembers)
 		{
-			GenerateStatement(*stmt);
+			fields.push_back(GetConstant((*value.Fields)[member.Index], *member.SemanticType));
 		}
+		return llvm::ConstantStruct::get(structType, fields);
+	}
+	else if (llvmType->isIntegerTy())
+	{
+		return llvm::ConstantInt::get(llvmType, value.Int, value.Int < 0);
 	}
 
-	// Close Loop Block
-	if (!builder.GetInsertBlock()->getTerminator())
-		builder.CreateBr(condBlock);
-
-	// Merge Block
-	builder.SetInsertPoint(mergeBlock);
-
-	phiTable = oldPHITable;
-	return mergeBlock;
+	if (value.Fields)
+		throw std::runtime_error("Constants can't hold pointers to objects.");
+	return llvm::Constant::getNullValue(llvmType);
 }
 
-llvm::Value* Overcast::CodeGen::CGEngine::GetStructMemberPointer(const std::string& structName, llvm::Value* structInst, const std::string& memberName)
+llvm::Value* Overcast::CodeGen::CGEngine::GetStructMemberPointer(const StructDef& structDef, llvm::Value* structInst, const StructDef::StructMember& member)
 {
-	auto structDef = structDefTable[structName];
-	return builder.CreateStructGEP(structDef.StructType, structInst, structDef.StructMembers[memberName].Index, ".gep" + structName + memberName);
+	return builder.CreateStructGEP(structDef.StructType, structInst, member.Index, ".gep" + llvm::StringRef(member.Name));
 }
 
 Overcast::CodeGen::CGResult Overcast::CodeGen::CGEngine::GenerateExpression(Expression& expression)
 {
+	if (expression.IsConstant) // folded by the binder, a folded value is never assigned to so this holds for pointer access too
+	{
+		auto* type = GetLLVMType(*expression.ResolvedType);
+		return { llvm::ConstantInt::get(type, expression.ConstantValue, expression.ConstantValue < 0), type, expression.ResolvedType };
+	}
+
 	if (auto invFunc = dynamic_cast<InvokeFunctionExpr*>(&expression))
 	{
 		return GenerateFunctionCall(*invFunc);
 	}
 	else if (auto strExpr = dynamic_cast<StringLiteralExpr*>(&expression))
 	{
-		llvm::Value* strValue = builder.CreateGlobalString(strExpr->LiteralValue, ".str");
+		llvm::Value* strValue = GetStringConstant(strExpr->LiteralValue);
 		return { strValue, llvm::PointerType::getInt8Ty(context) };
 	}
 	else if (auto intExpr = dynamic_cast<IntLiteralExpr*>(&expression))
@@ -579,30 +840,41 @@ Overcast::CodeGen::CGResult Overcast::CodeGen::CGEngine::GenerateExpression(Expr
 		llvm::Value* intValue = llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), intExpr->LiteralValue);
 		return { intValue, llvm::Type::getInt32Ty(context) };
 	}
+	else if (auto boolExpr = dynamic_cast<BoolLiteralExpr*>(&expression))
+	{
+		llvm::Value* boolValue = llvm::ConstantInt::get(llvm::Type::getInt1Ty(context), boolExpr->LiteralValue);
+		return { boolValue, llvm::Type::getInt1Ty(context) };
+	}
 	else if (auto varExpr = dynamic_cast<VariableUseExpr*>(&expression))
 	{
-		if (symbolTable.find(varExpr->VariableName) == symbolTable.end() && !varExpr->isFunc)
+		const auto* varSymbol = varExpr->ResolvedSymbol;
+		if (varSymbol->Kind == Overcast::Semantic::Binder::SymbolKind::Function) // func check
 		{
-			throw std::runtime_error("Variable " + varExpr->VariableName + " not found in symbol table.");
+			auto* function = GetFunction(*varSymbol);
+			return { function, function->getReturnType(), varSymbol->Type };
 		}
-		if (!varExpr->isFunc) // var check
+
+		if (varSymbol->ConstObject) // a struct const, it lives in a constant global
 		{
-			if (symbolTable[varExpr->VariableName]->getName().starts_with("var:"))
-			{
-				llvm::Value* ptrValue = symbolTable[varExpr->VariableName];
-				if (RequestPointerAccess)
-				{
-					return { ptrValue, llvm::dyn_cast<llvm::AllocaInst>(ptrValue)->getAllocatedType(), semanticTypeTable[varExpr->VariableName] };
-				}
-				return { builder.CreateLoad(llvm::dyn_cast<llvm::AllocaInst>(ptrValue)->getAllocatedType(), ptrValue, varExpr->VariableName), llvm::dyn_cast<llvm::AllocaInst>(ptrValue)->getAllocatedType(), semanticTypeTable[varExpr->VariableName] };
-			}
+			auto* global = GetConstGlobal(*varSymbol);
+			if (!RequestPointerAccess) // by value, same as a struct var
+				return { builder.CreateLoad(global->getValueType(), global, varExpr->VariableName), global->getValueType(), varSymbol->Type };
+			return { global, global->getValueType(), varSymbol->Type };
 		}
-		else if(varExpr->isFunc) // func check
+
+		auto it = valueTable.find(varSymbol);
+		if (it == valueTable.end())
 		{
-			return { symbolTable["func:"+varExpr->VariableName], typedSymbolTable[varExpr->VariableName].type, semanticTypeTable[varExpr->VariableName]};
+			throw std::runtime_error("Variable " + varExpr->VariableName + " not found in symbol table.");
 		}
 
-		return { symbolTable[varExpr->VariableName], typedSymbolTable[varExpr->VariableName].type, semanticTypeTable[varExpr->VariableName] };
+		const auto& local = it->second;
+		if (local.isSlot && !RequestPointerAccess) // var check
+		{
+			return { builder.CreateLoad(local.type, local.value, varExpr->VariableName), local.type, varSymbol->Type };
+		}
+
+		return { local.value, local.type, varSymbol->Type };
 	}
 	else if (auto strCtorExpr = dynamic_cast<StructCtorExpr*>(&expression))
 	{
@@ -610,74 +882,78 @@ Overcast::CodeGen::CGResult Overcast::CodeGen::CGEngine::GenerateExpression(Expr
 	}
 	else if (auto strAccExpr = dynamic_cast<StructAccessExpr*>(&expression))
 	{
-		auto memberName = strAccExpr->MemberName;
 		bool prevPointerState = RequestPointerAccess;
 		RequestPointerAccess = true;
 		auto structInst = GenerateExpression(*strAccExpr->LHS); // this should be an alloca instance (ex. LHS is a struct access expr, so it goes StrAccExpr->StrAccExpr->VarExpr)
 		RequestPointerAccess = prevPointerState;
 
-		std::string structName = structInst.semanticType->getBaseType()->to_string();
+		const auto& structDef = GetStructDef(*strAccExpr->ResolvedStruct);
+		const auto* resolvedMember = strAccExpr->ResolvedSymbol;
 
-		if (this->RequestPointerAccess)
+		if (this->RequestFunctionAccess && resolvedMember->FieldIndex < 0)
 		{
-			auto strMemGEP = GetStructMemberPointer(structName, structInst.value, memberName);
-			return { strMemGEP, structDefTable[structName].StructMembers[memberName].Type, structDefTable[structName].StructMembers[memberName].SemanticType };
+			auto* func = GetFunction(*resolvedMember);
+			return { func, func->getReturnType(), resolvedMember->Type, structInst.value};
 		}
-		if (this->RequestFunctionAccess)
-		{
-			auto structDef = structDefTable[structName];
-			auto* func = module->getFunction("func:"+structName + "::" + memberName);
 
-			return { func, func->getReturnType(), semanticTypeTable[structName + "::" + memberName], structInst.value};
+		const auto& member = structDef.StructMembers[resolvedMember->FieldIndex];
+		auto strMemGEP = GetStructMemberPointer(structDef, structInst.value, member);
+		if (this->RequestPointerAccess)
+		{
+			return { strMemGEP, member.Type, member.SemanticType };
 		}
 
-		auto structDef = structDefTable[structName];
-		auto strMemGEP = GetStructMemberPointer(structName, structInst.value, memberName);
-		return { builder.CreateLoad(structDef.StructMembers[memberName].Type, strMemGEP, ".structInstLoad"), structDefTable[structName].StructMembers[memberName].Type, structDefTable[structName].StructMembers[memberName].SemanticType };
+		return { builder.CreateLoad(member.Type, strMemGEP, ".structInstLoad"), member.Type, member.SemanticType };
 	}
 	else if (auto binExpr = dynamic_cast<BinaryExpr*>(&expression))
 	{
 		auto c_lhs = GenerateExpression(*binExpr->A.get());
 		auto c_rhs = GenerateExpression(*binExpr->B.get());
 
-		auto* lhs = c_lhs.value;
-		auto* rhs = c_rhs.value;
-
-		auto op = binExpr->Operator;
-
-		if (op == "+")
-			return { builder.CreateAdd(lhs, rhs, "addtmp"), c_lhs.type };
-		else if (op == "-")
-			return {builder.CreateSub(lhs, rhs, "subtmp"), c_lhs.type };
-		else if (op == "*")
-			return {builder.CreateMul(lhs, rhs, "multmp"), c_lhs.type };
-		else if (op == "/")
-			return {builder.CreateSDiv(lhs, rhs, "divtmp"), c_lhs.type };
-		else if (op == "%")
-			return {builder.CreateSRem(lhs, rhs, "modtmp"), c_lhs.type };
-		else if (op == "==")
-			return {builder.CreateICmpEQ(lhs, rhs, "eqtmp"), c_lhs.type };
-		else if (op == "!=")
-			return {builder.CreateICmpNE(lhs, rhs, "netmp"), c_lhs.type };
-		else if (op == "<")
-			return {builder.CreateICmpSLT(lhs, rhs, "lttmp"), c_lhs.type };
-		else if (op == "<=")
-			return {builder.CreateICmpSLE(lhs, rhs, "letmp"), c_lhs.type };
-		else if (op == ">")
-			return {builder.CreateICmpSGT(lhs, rhs, "gttmp"), c_lhs.type };
-		else if (op == ">=")
-			return {builder.CreateICmpSGE(lhs, rhs, "getmp"), c_lhs.type };
-		else if (op == "&&")
-			return {builder.CreateAnd(lhs, rhs, "andtmp"), c_lhs.type };
-		else if (op == "||")
-			return {builder.CreateOr(lhs, rhs, "ortmp"), c_lhs.type };
-		else
-			throw std::runtime_error("Unsupported binary operator.");
+		return { GenerateBinaryOp(binExpr->Operator, c_lhs.value, c_rhs.value), c_lhs.type };
 	}
 }
 
+llvm::Value* Overcast::CodeGen::CGEngine::GenerateBinaryOp(const std::string& op, llvm::Value* lhs, llvm::Value* rhs)
+{
+	if (op == "+")
+		return builder.CreateAdd(lhs, rhs, "addtmp");
+	else if (op == "-")
+		return builder.CreateSub(lhs, rhs, "subtmp");
+	else if (op == "*")
+		return builder.CreateMul(lhs, rhs, "multmp");
+	else if (op == "/")
+		return builder.CreateSDiv(lhs, rhs, "divtmp");
+	else if (op == "%")
+		return builder.CreateSRem(lhs, rhs, "modtmp");
+	else if (op == "==")
+		return builder.CreateICmpEQ(lhs, rhs, "eqtmp");
+	else if (op == "!=")
+		return builder.CreateICmpNE(lhs, rhs, "netmp");
+	else if (op == "<")
+		return builder.CreateICmpSLT(lhs, rhs, "lttmp");
+	else if (op == "<=")
+		return builder.CreateICmpSLE(lhs, rhs, "letmp");
+	else if (op == ">")
+		return builder.CreateICmpSGT(lhs, rhs, "gttmp");
+	else if (op == ">=")
+		return builder.CreateICmpSGE(lhs, rhs, "getmp");
+	else if (op == "&&")
+		return builder.CreateAnd(lhs, rhs, "andtmp");
+	else if (op == "||")
+		return builder.CreateOr(lhs, rhs, "ortmp");
+	else
+		throw std::runtime_error("Unsupported binary operator.");
+}
+
 Overcast::CodeGen::CGResult Overcast::CodeGen::CGEngine::GenerateFunctionCall(const InvokeFunctionExpr& funcCall)
 {
+	if (funcCall.ResolvedSymbol->IsBuiltin && funcCall.ResolvedSymbol->Name == "print")
+	{
+		if (auto direct = GenerateDirectPrint(funcCall))
+			return *direct;
+	}
+
 	auto reqFlag = RequestFunctionAccess;
 	RequestFunctionAccess = true;
 	auto c_value = GenerateExpression(*funcCall.InvokedFunction);
@@ -691,30 +967,145 @@ Overcast::CodeGen::CGResult Overcast::CodeGen::CGEngine::GenerateFunctionCall(co
 		throw std::runtime_error("Function " + value->getName().str() + " not found.");
 	}
 
-	if (function->getName() == "print") // check for the print function, we need to replace that with printf
-	{
-		function = module->getFunction("printf");
-	}
-
 	std::vector<llvm::Value*> args;
 	for (auto& arg : funcCall.Arguments)
 	{
 		args.push_back(GenerateExpression(*arg).value);
 	}
 
-	if (funcCall.IsStructFunc)
+	if (funcCall.ResolvedSymbol->IsStructMemberFunc)
+	{
+		auto* object = c_value.structObject;
+
+		// consts live in read-only memory and the method may write to 'this', so it gets a copy to work on
+		// (consts can't hold pointers, so the copy is the whole object)
+		auto* method = dynamic_cast<const StructAccessExpr*>(funcCall.InvokedFunction.get());
+		const Expression* root = method ? method->LHS.get() : nullptr;
+		while (auto strAcc = dynamic_cast<const StructAccessExpr*>(root))
+			root = strAcc->LHS.get();
+		auto* rootVar = dynamic_cast<const VariableUseExpr*>(root);
+		if (rootVar && rootVar->ResolvedSymbol && rootVar->ResolvedSymbol->ConstObject)
+		{
+			const auto& structDef = GetStructDef(*method->ResolvedStruct);
+			auto* copy = CreateScopedSlot(structDef.StructType, "constCopy:" + rootVar->VariableName);
+			builder.CreateStore(builder.CreateLoad(structDef.StructType, object), copy);
+			object = copy;
+		}
+
+		args.push_back(object);
+	}
+
+	return { builder.CreateCall(function, args, function->getReturnType()->isVoidTy() ? "" : "calltmp"), function->getReturnType(), funcCall.ResolvedType };
+}
+
+std::optional<Overcast::CodeGen::CGResult> Overcast::CodeGen::CGEngine::GenerateDirectPrint(const InvokeFunctionExpr& funcCall)
+{
+	if (funcCall.Arguments.empty())
+		return std::nullopt;
+
+	auto* formatExpr = dynamic_cast<StringLiteralExpr*>(funcCall.Arguments[0].get());
+	if (!formatExpr)
+		return std::nullopt;
+
+	// split the format into literal runs and the args that go between them,
+	// only %d, %i and %s are known here, anything else (widths, other conversions...) is left to oc_printf
+	struct Piece
+	{
+		std::string Text;
+		size_t Argument = 0; // 0 for literal text, the format itself is argument 0
+	};
+
+	std::vector<Piece> pieces;
+	std::string text;
+	size_t nextArgument = 1;
+	const auto& format = formatExpr->LiteralValue;
+	for (size_t i = 0; i < format.size(); i++)
+	{
+		if (format[i] != '%')
+		{
+			text += format[i];
+			continue;
+		}
+
+		if (i + 1 >= format.size())
+			return std::nullopt;
+
+		char conversion = format[++i];
+		if (conversion == '%')
+		{
+			text += '%';
+			continue;
+		}
+
+		if (nextArgument >= funcCall.Arguments.size())
+			return std::nullopt;
+
+		auto typeName = funcCall.Arguments[nextArgument]->ResolvedType->to_string();
+		bool isInt = (conversion == 'd' || conversion == 'i') && (typeName == "int" || typeName == "bool");
+		bool isString = conversion == 's' && typeName == "string";
+		if (!isInt && !isString)
+			return std::nullopt;
+
+		if (!text.empty())
+			pieces.push_back({ std::move(text) });
+		text.clear();
+		pieces.push_back({ "", nextArgument++ });
+	}
+
+	if (nextArgument != funcCall.Arguments.size()) // printf would still evaluate the extra ones, so leave it to oc_printf
+		return std::nullopt;
+
+	if (!text.empty())
+		pieces.push_back({ std::move(text) });
+
+	// all the args go first, a call in one of them could print something itself
+	std::vector<llvm::Value*> args(funcCall.Arguments.size());
+	for (size_t i = 1; i < funcCall.Arguments.size(); i++)
 	{
-		args.push_back(c_value.structObject);
+		args[i] = GenerateExpression(*funcCall.Arguments[i]).value;
 	}
 
-	return { builder.CreateCall(function, args, function->getReturnType()->isVoidTy() ? "" : "calltmp"), function->getReturnType(), semanticTypeTable[function->getName().str()] };
+	auto* int32Type = llvm::Type::getInt32Ty(context);
+	auto* strType = llvm::PointerType::get(llvm::Type::getInt8Ty(context), 0);
+
+	// every piece says how much it wrote, so print still returns what printf would
+	llvm::Value* written = builder.getInt32(0);
+	for (const auto& piece : pieces)
+	{
+		llvm::Value* count = nullptr;
+		if (piece.Argument == 0)
+		{
+			auto writeBytes = GetRuntimeFunction("oc_write_bytes", { strType, llvm::Type::getInt64Ty(context) });
+			count = builder.CreateCall(writeBytes, { GetStringConstant(piece.Text), builder.getInt64(piece.Text.size()) });
+		}
+		else if (args[piece.Argument]->getType()->isPointerTy())
+		{
+			count = builder.CreateCall(GetRuntimeFunction("oc_write_str", { strType }), { args[piece.Argument] });
+		}
+		else
+		{
+			auto* value = builder.CreateZExtOrTrunc(args[piece.Argument], int32Type); // bools print as 0/1
+			count = builder.CreateCall(GetRuntimeFunction("oc_write_i32", { int32Type }), { value });
+		}
+		written = builder.CreateAdd(written, count);
+	}
+
+	return CGResult{ written, int32Type, funcCall.ResolvedType };
 }
 
 Overcast::CodeGen::CGResult Overcast::CodeGen::CGEngine::GenerateStructCtor(StructCtorExpr* strCtorExpr, llvm::Value* overridePtr)
 {
-	// okay time to find the ctor, if I can't find it, then I just "pretend" there's a default one that just makes the object
-	auto ctorFunction = module->getFunction("func:" + strCtorExpr->StructTypeName + "::" + "ctor");
-	auto structObject = overridePtr == nullptr ? builder.CreateAlloca(structDefTable[strCtorExpr->StructTypeName].StructType, nullptr, "structObj:" + strCtorExpr->StructTypeName) : overridePtr;
+	// okay time to find the ctor, if there's none then I just "pretend" there's a default one that just makes the object
+	const auto& structDef = GetStructDef(*strCtorExpr->ResolvedSymbol);
+	auto ctorFunction = strCtorExpr->ResolvedCtor ? GetFunction(*strCtorExpr->ResolvedCtor) : nullptr;
+	llvm::Value* structObject = overridePtr;
+	if (!structObject)
+	{
+		if (strCtorExpr->Escapes)
+			structObject = builder.CreateCall(GetAllocator(), { llvm::ConstantExpr::getSizeOf(structDef.StructType) }, "heapObj:" + strCtorExpr->StructTypeName);
+		else
+			structObject = CreateScopedSlot(structDef.StructType, "structObj:" + strCtorExpr->StructTypeName);
+	}
 
 	if (ctorFunction)
 	{
@@ -725,64 +1116,192 @@ Overcast::CodeGen::CGResult Overcast::CodeGen::CGEngine::GenerateStructCtor(Stru
 		}
 
 		args.push_back(structObject);
-		builder.CreateCall(ctorFunction, args, "ctor_call");
+		builder.CreateCall(ctorFunction, args, ctorFunction->getReturnType()->isVoidTy() ? "" : "ctor_call");
+	}
+
+	return { structObject, structDef.StructType, strCtorExpr->ResolvedType };
+}
+
+void Overcast::CodeGen::CGEngine::EnterSlotScope()
+{
+	slotScopes.emplace_back();
+}
+
+void Overcast::CodeGen::CGEngine::ExitSlotScope()
+{
+	// a block that already returned/branched away doesn't need the ends, leaving the frame ends everything
+	if (!builder.GetInsertBlock()->getTerminator())
+	{
+		for (auto* slot : slotScopes.back())
+		{
+			builder.CreateLifetimeEnd(slot);
+		}
+	}
+
+	// the block's over, so later blocks can have its slots
+	for (auto* slot : slotScopes.back())
+	{
+		freeSlots[slot->getAllocatedType()].push_back(slot);
+	}
+	slotScopes.pop_back();
+}
+
+llvm::AllocaInst* Overcast::CodeGen::CGEngine::CreateScopedSlot(llvm::Type* type, const std::string& name)
+{
+	// the alloca itself is in the entry block so loops reuse one slot instead of growing the stack,
+	// and a slot whose block already ended gets reused so the frame only holds what's live at once
+	llvm::AllocaInst* slot = nullptr;
+	auto& pool = freeSlots[type];
+	if (!pool.empty())
+	{
+		slot = pool.back();
+		pool.pop_back();
+	}
+	else
+	{
+		slot = CreateEntryBlockAlloca(type, name);
+	}
+
+	builder.CreateLifetimeStart(slot);
+	slotScopes.back().push_back(slot);
+	return slot;
+}
+
+void Overcast::CodeGen::CGEngine::PromoteSlots()
+{
+	// runs at every opt level, so even unoptimized builds hand the backend SSA instead of loads and stores
+	llvm::PassBuilder passBuilder;
+	llvm::FunctionAnalysisManager functionAM;
+	passBuilder.registerFunctionAnalyses(functionAM);
+
+	llvm::FunctionPassManager functionPM;
+	functionPM.addPass(llvm::PromotePass());
+
+	for (auto& function : *module)
+	{
+		if (!function.isDeclaration())
+			functionPM.run(function, functionAM);
+	}
+}
+
+llvm::FunctionCallee Overcast::CodeGen::CGEngine::GetAllocator()
+{
+	auto* allocType = llvm::FunctionType::get(llvm::PointerType::get(llvm::Type::getInt8Ty(context), 0), { llvm::Type::getInt64Ty(context) }, false);
+	return module->getOrInsertFunction("malloc", allocType);
+}
+
+llvm::FunctionCallee Overcast::CodeGen::CGEngine::GetRuntimeFunction(const std::string& name, llvm::ArrayRef<llvm::Type*> params)
+{
+	auto* type = llvm::FunctionType::get(llvm::Type::getInt32Ty(context), params, false);
+	auto callee = module->getOrInsertFunction(name, type);
+	if (auto* function = llvm::dyn_cast<llvm::Function>(callee.getCallee()))
+		function->addFnAttr(llvm::Attribute::NoUnwind);
+	return callee;
+}
+
+llvm::Function* Overcast::CodeGen::CGEngine::GetFunction(const Overcast::Semantic::Binder::Symbol& funcSymbol)
+{
+	auto it = functionTable.find(&funcSymbol);
+	if (it != functionTable.end())
+		return it->second;
+
+	llvm::Function* function = nullptr;
+	if (funcSymbol.IsBuiltin) // print -> oc_printf, flush -> oc_flush
+	{
+		if (funcSymbol.Name == "flush")
+		{
+			function = llvm::cast<llvm::Function>(module->getOrInsertFunction("oc_flush", llvm::Type::getVoidTy(context)).getCallee());
+			function->addFnAttr(llvm::Attribute::NoUnwind);
+		}
+		else
+		{
+			function = module->getFunction("oc_printf");
+		}
+	}
+	else
+	{
+		// another symbol for the same function (e.g. the global one) may have declared it already
+		function = module->getFunction(funcSymbol.LinkName);
+		if (!function)
+		{
+			std::vector<llvm::Type*> parameters;
+			for (const auto& param : funcSymbol.ParamTypes)
+			{
+				parameters.push_back(GetLLVMType(*param));
+			}
+
+			llvm::FunctionType* fType = llvm::FunctionType::get(GetLLVMType(*funcSymbol.Type), parameters, funcSymbol.Variadic);
+			function = llvm::Function::Create(fType, llvm::Function::ExternalLinkage, funcSymbol.LinkName, module.get());
+			if (!funcSymbol.IsExtern)
+				function->addFnAttr(llvm::Attribute::NoUnwind); // there are no exceptions in the language
+		}
 	}
 
-	semanticTypeTable[strCtorExpr->StructTypeName] = structDefTable[strCtorExpr->StructTypeName].SemanticType;
-	return { structObject, structDefTable[strCtorExpr->StructTypeName].StructType, IdentifierType::GetVoidType() };
+	functionTable.insert({ &funcSymbol, function });
+	return function;
 }
 
 llvm::Type* Overcast::CodeGen::CGEngine::GetLLVMType(OCType& ocType)
 {
+	auto cached = llvmTypeTable.find(&ocType);
+	if (cached != llvmTypeTable.end())
+		return cached->second;
+
+	llvm::Type* llvmType = nullptr;
 	if (auto type = dynamic_cast<PointerType*>(&ocType))
 	{
-		return llvm::PointerType::get(GetLLVMType(*type->OfType), 0);
+		llvmType = llvm::PointerType::get(GetLLVMType(*type->OfType), 0);
 	}
 	else if (auto type = dynamic_cast<IdentifierType*>(&ocType))
 	{
 		// handle primitives first:
 		if (type->TypeName == "int")
 		{
-			return llvm::Type::getInt32Ty(context);
+			llvmType = llvm::Type::getInt32Ty(context);
 		}
 		else if (type->TypeName == "float")
 		{
-			return llvm::Type::getFloatTy(context);
+			llvmType = llvm::Type::getFloatTy(context);
 		}
 		else if (type->TypeName == "double")
 		{
-			return llvm::Type::getDoubleTy(context);
+			llvmType = llvm::Type::getDoubleTy(context);
 		}
 		else if (type->TypeName == "void")
 		{
-			return llvm::Type::getVoidTy(context);
+			llvmType = llvm::Type::getVoidTy(context);
 		}
 		else if (type->TypeName == "string")
 		{
-			return llvm::PointerType::get(llvm::Type::getInt8Ty(context), 0);
+			llvmType = llvm::PointerType::get(llvm::Type::getInt8Ty(context), 0);
 		}
 		else if (type->TypeName == "byte")
 		{
-			return llvm::Type::getInt8Ty(context);
+			llvmType = llvm::Type::getInt8Ty(context);
 		}
 		else if (type->TypeName == "bool")
 		{
-			return llvm::Type::getInt1Ty(context);
+			llvmType = llvm::Type::getInt1Ty(context);
 		}
 		else if (type->TypeName == "char")
 		{
-			return llvm::Type::getInt8Ty(context);
+			llvmType = llvm::Type::getInt8Ty(context);
 		}
 		else
 		{
 			// check struct types
-			if (structDefTable.find(type->TypeName) != structDefTable.end())
-			{
-				return structDefTable[type->TypeName].StructType;
-			}
-			throw std::runtime_error("Unknown type: " + type->TypeName);
+			auto structIt = structDefTable.find(type->TypeName);
+			if (structIt == structDefTable.end())
+				throw std::runtime_error("Unknown type: " + type->TypeName);
+			llvmType = structIt->second.StructType;
 		}
 	}
+
+	if (!llvmType)
+		throw std::runtime_error("Unknown type");
+
+	llvmTypeTable.insert({ &ocType, llvmType });
+	return llvmType;
 }
 
 Overcast::CodeGen::CGEngine::~CGEngine()
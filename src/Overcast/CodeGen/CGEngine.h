@@ -1,13 +1,16 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "Overcast/SyntaxAnalysis/statements.h"
 #include "Overcast/SyntaxAnalysis/expressions.h"
 #include "Overcast/SemanticAnalysis/binder.h"
+#include "Overcast/SemanticAnalysis/const_evaluator.h"
 
 namespace llvm {
 	class LLVMContext;
@@ -18,6 +21,41 @@ namespace llvm {
 }
 
 namespace Overcast::CodeGen {
+	enum class OptLevel
+	{
+		O0,
+		O1,
+		O2,
+		O3,
+		Os,
+		Oz
+	};
+
+	// takes "O2", "-O2" or just "2", case doesn't matter
+	std::optional<OptLevel> ParseOptLevel(std::string level);
+
+	enum class LTOMode
+	{
+		None,
+		Thin // objects are bitcode with summaries, the linker optimizes across them
+	};
+
+	std::optional<LTOMode> ParseLTOMode(const std::string& mode); // "none" or "thin"
+
+	// everything about how the generated code gets optimized, one per build
+	struct CodeGenOptions
+	{
+		OptLevel Level = OptLevel::O2;
+		std::string CPU = "generic"; // or "native" until ResolveHostTarget runs
+		std::string Features; // comma separated, "+avx2,-fma" like -mattr
+		uint32_t SplitParts = 1; // above 1, each module is split up and the parts are optimized and emitted in parallel
+		LTOMode LTO = LTOMode::None;
+		bool WholeProgram = false; // every file goes into one module, so the optimizer sees the whole program at once
+	};
+
+	// turns a "native" CPU into the host's name and features, features that were asked for explicitly still win
+	void ResolveHostTarget(CodeGenOptions& options);
+
 	struct StructDef
 	{
 		struct StructMember
@@ -27,21 +65,16 @@ namespace Overcast::CodeGen {
 			int Index;
 			OCType* SemanticType;
 		};
-		llvm::Type* StructType;
-		std::map<std::string, StructMember> StructMembers;
+		llvm::StructType* StructType;
+		std::vector<StructMember> StructMembers; // indexed by field index
 		OCType* SemanticType;
 	};
 
-	struct SymbolDef
-	{
-		llvm::Type* type; // may add more
-	};
-
-	struct PhiVariable
+	struct LocalValue
 	{
 		llvm::Value* value;
 		llvm::Type* type;
-		std::string name;
+		bool isSlot; // a var alloca that gets loaded on use, anything else is used as is
 	};
 
 	struct CGResult
@@ -58,20 +91,35 @@ namespace Overcast::CodeGen {
 		llvm::IRBuilder<> builder;
 		std::unique_ptr<llvm::Module> module;
 		llvm::Function* currentFunction = nullptr;
+		CodeGenOptions options;
+		const std::unordered_set<std::string>* calledElsewhere = nullptr; // link names other files call, null when there are no other modules
 
 		bool RequestPointerAccess = false; // a lil' flag for struct access
 		bool RequestFunctionAccess = false; // same as above
-		bool analyzePhiVariables = false; // for looping
 
-		std::unordered_map<std::string, llvm::Value*> symbolTable;
-		std::unordered_map<std::string, llvm::PHINode*> phiTable;
-		std::unordered_map<std::string, SymbolDef> typedSymbolTable;
-		std::unordered_map<std::string, OCType*> semanticTypeTable;
+		// everything past declaration is keyed by the symbols the binder resolved
+		std::unordered_map<const Overcast::Semantic::Binder::Symbol*, LocalValue> valueTable;
+		std::unordered_map<const Overcast::Semantic::Binder::Symbol*, llvm::Function*> functionTable;
+		std::unordered_map<const OCType*, llvm::Type*> llvmTypeTable;
 		std::unordered_map<std::string, StructDef> structDefTable;
+		std::unordered_map<const Overcast::Semantic::Binder::Symbol*, StructDef*> structDefsBySymbol; // filled on first access
+		std::unordered_map<const Overcast::Semantic::Binder::Symbol*, llvm::GlobalVariable*> constGlobalTable; // struct consts, made on first use
+		std::unordered_map<std::string, llvm::GlobalVariable*> stringPool; // one global per distinct literal in the module
 
-		std::vector<PhiVariable> PhiVariableList; // this gets cleared for each analysis
+		// stack objects live from their lifetime.start to the end of the block that made them
+		// every local and temporary gets its slot from CreateScopedSlot, only whole-function slots use CreateEntryBlockAlloca directly
+		std::vector<std::vector<llvm::AllocaInst*>> slotScopes;
+		std::unordered_map<llvm::Type*, std::vector<llvm::AllocaInst*>> freeSlots; // slots of ended blocks, per function
+		void EnterSlotScope();
+		void ExitSlotScope();
+		llvm::AllocaInst* CreateEntryBlockAlloca(llvm::Type* type, const std::string& name);
+		llvm::AllocaInst* CreateScopedSlot(llvm::Type* type, const std::string& name);
+		llvm::FunctionCallee GetAllocator(); // for objects that outlive their frame
+		llvm::FunctionCallee GetRuntimeFunction(const std::string& name, llvm::ArrayRef<llvm::Type*> params); // from oc_runtime.h, they all return an i32
+		void PromoteSlots(); // mem2reg over every function, vars only become SSA values here
 
-		llvm::BasicBlock* currentLoopBlock = nullptr;
+		void DeclareGlobals(const Overcast::Semantic::Binder::GlobalSymbolIndex& globalSymbols); // oc_printf and the struct layouts, once per module
+		void GenerateFile(const std::vector<std::unique_ptr<Statement>>& statements);
 
 		llvm::Value* GenerateStatement(Statement& statement);
 		llvm::Value* GenerateFunction(const FunctionDeclStatement& funcDecl);
@@ -79,23 +127,41 @@ namespace Overcast::CodeGen {
 		llvm::Value* GenerateStructDecl(const StructDeclStatement& strDecl);
 		llvm::Value* GenerateVarDecl(const VariableDeclStatement& varDecl);
 		llvm::Value* GenerateVarSet(const AssignmentStatement& varSet);
+		llvm::Value* GenerateCompoundAssignment(const CompoundAssignmentStatement& assign);
+		llvm::Value* GenerateBinaryOp(const std::string& op, llvm::Value* lhs, llvm::Value* rhs);
 		llvm::Value* GenerateIfStatement(const IfStatement& ifStmt, llvm::BasicBlock* mergeBlock = nullptr);
-		std::string AnalyzeExpression(Expression& expression);
-		std::vector<PhiVariable> AnalyzePHIVariables(const std::vector<std::unique_ptr<Statement>>& statements);
-		llvm::Value* GenerateWhileStatement(const WhileStatement& whStmt, llvm::BasicBlock* parentCondition = nullptr);
+		llvm::Value* GenerateWhileStatement(const WhileStatement& whStmt);
+		llvm::Value* GenerateForStatement(const ForStatement& forStmt);
+		llvm::BasicBlock* GenerateLoop(const Statement& loopStmt, Expression* condition, const std::vector<std::unique_ptr<Statement>>& body, Statement* step); // returns the exit block
+		llvm::MDNode* GetLoopMetadata(const Statement& loopStmt); // from #vectorize/#unroll, null if there are none
 		CGResult GenerateExpression(Expression& expression);
 		CGResult GenerateFunctionCall(const InvokeFunctionExpr& funcCall);
+		std::optional<CGResult> GenerateDirectPrint(const InvokeFunctionExpr& funcCall); // nullopt if the format has to be parsed at runtime
 		CGResult GenerateStructCtor(StructCtorExpr* strCtorExpr, llvm::Value* overridePtr = nullptr);
 		llvm::Type* GetLLVMType(OCType& ocType);
-		llvm::Value* GetStructMemberPointer(const std::string& structName, llvm::Value* structInst, const std::string& memberName);
+		llvm::Function* GetFunction(const Overcast::Semantic::Binder::Symbol& funcSymbol);
+		const StructDef& GetStructDef(const Overcast::Semantic::Binder::Symbol& structSymbol);
+		llvm::Value* GetStructMemberPointer(const StructDef& structDef, llvm::Value* structInst, const StructDef::StructMember& member);
+		llvm::GlobalVariable* GetConstGlobal(const Overcast::Semantic::Binder::Symbol& constSymbol);
+		llvm::GlobalVariable* GetStringConstant(const std::string& value);
+
+		static void EmitModule(llvm::Module& module, const std::string& outputFile, const CodeGenOptions& options);
+		static std::string GetPartPath(const std::string& outputFile, size_t part); // foo.oc.obj -> foo.oc.part0.obj
+		static void MakeLocalsUnique(llvm::Module& module, const std::string& outputFile); // so they can be exported between parts
+		llvm::Constant* GetConstant(const Overcast::Semantic::ConstValue& value, OCType& type);
 	public:
 		~CGEngine();
 
-		llvm::Module* Generate(std::unordered_map<std::string, Overcast::Semantic::Binder::Symbol> globalSymbols, const std::vector<std::unique_ptr<Statement>>& statements);
+		// functions that aren't exported, main, or in calledElsewhere get internal linkage
+		llvm::Module* Generate(const Overcast::Semantic::Binder::GlobalSymbolIndex& globalSymbols, const std::vector<std::unique_ptr<Statement>>& statements, const std::unordered_set<std::string>& calledElsewhere);
+		// every file into this one module, and everything but main and exported functions gets internal linkage
+		llvm::Module* GenerateProgram(const Overcast::Semantic::Binder::GlobalSymbolIndex& globalSymbols, const std::vector<const std::vector<std::unique_ptr<Statement>>*>& files);
 		void EmitToObjectFile(const std::string& outputFile, llvm::Module* module);
 
-		CGEngine(const std::string& moduleName)
-			: builder(context), module(std::make_unique<llvm::Module>(moduleName, context)) {
+		static void RemoveObjectFile(const std::string& outputFile); // and any parts it was split into
+
+		CGEngine(const std::string& moduleName, const CodeGenOptions& options = {})
+			: builder(context), module(std::make_unique<llvm::Module>(moduleName, context)), options(options) {
 		}
 	};
 };
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "ocpch.h"
+#include "CGTarget.h"
+
+Overcast::CodeGen::CGTarget& Overcast::CodeGen::CGTarget::Get()
+{
+	static CGTarget instance; // first caller initializes it, everyone else waits
+	return instance;
+}
+
+Overcast::CodeGen::CGTarget::CGTarget()
+{
+	// we only ever emit for the machine we're running on, so there's no point registering every backend
+	llvm::InitializeNativeTarget();
+	llvm::InitializeNativeTargetAsmPrinter();
+	llvm::InitializeNativeTargetAsmParser();
+
+	triple = llvm::sys::getDefaultTargetTriple();
+
+	std::string error;
+	target = llvm::TargetRegistry::lookupTarget(triple, error);
+	if (!target)
+	{
+		throw std::runtime_error("Could not find a target for " + triple + ": " + error);
+	}
+}
+
+Overcast::CodeGen::CGTarget::TargetMachineHandle Overcast::CodeGen::CGTarget::AcquireTargetMachine(const CodeGenOptions& options)
+{
+	// the size levels still want the usual instruction selection, optsize/minsize on the functions does the rest
+	llvm::CodeGenOptLevel codeGenLevel = llvm::CodeGenOptLevel::Default;
+	switch (options.Level)
+	{
+	case OptLevel::O0: codeGenLevel = llvm::CodeGenOptLevel::None; break;
+	case OptLevel::O1: codeGenLevel = llvm::CodeGenOptLevel::Less; break;
+	case OptLevel::O3: codeGenLevel = llvm::CodeGenOptLevel::Aggressive; break;
+	default: break;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(idleLock);
+		for (auto it = idleMachines.begin(); it != idleMachines.end(); ++it)
+		{
+			auto& machine = **it;
+			if (machine.getOptLevel() == codeGenLevel && machine.getTargetCPU() == options.CPU && machine.getTargetFeatureString() == options.Features)
+			{
+				TargetMachineHandle handle(it->release());
+				idleMachines.erase(it);
+				return handle;
+			}
+		}
+	}
+
+	llvm::TargetOptions opt;
+	auto RM = std::optional<llvm::Reloc::Model>();
+	TargetMachineHandle machine(target->createTargetMachine(triple, options.CPU, options.Features, opt, RM, std::nullopt, codeGenLevel));
+	if (!machine)
+	{
+		throw std::runtime_error("Could not create a target machine for " + triple + " (" + options.CPU + ")");
+	}
+
+	return machine;
+}
+
+void Overcast::CodeGen::CGTarget::MachineReturn::operator()(llvm::TargetMachine* machine) const
+{
+	auto& instance = CGTarget::Get();
+	std::lock_guard<std::mutex> lock(instance.idleLock);
+	instance.idleMachines.emplace_back(machine);
+}
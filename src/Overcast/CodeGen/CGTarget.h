@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CGEngine.h"
+
+namespace llvm {
+	class Target;
+	class TargetMachine;
+}
+
+namespace Overcast::CodeGen {
+	// the process-wide side of codegen, the native target gets registered once for the whole build
+	// and the TargetMachines are kept around for every module after it
+	class CGTarget
+	{
+	public:
+		struct MachineReturn
+		{
+			void operator()(llvm::TargetMachine* machine) const;
+		};
+		using TargetMachineHandle = std::unique_ptr<llvm::TargetMachine, MachineReturn>;
+
+		static CGTarget& Get();
+
+		// TargetMachines can't be used by two threads at once, so the caller has this one to itself until the handle goes away,
+		// then it goes back for whoever asks next (the split and body workers are new threads every time, so it can't be per thread)
+		// a new one is only built when none of the idle ones have these options
+		TargetMachineHandle AcquireTargetMachine(const CodeGenOptions& options);
+
+		const std::string& GetTriple() const
+		{
+			return triple;
+		}
+	private:
+		CGTarget();
+
+		std::string triple;
+		const llvm::Target* target = nullptr;
+
+		std::mutex idleLock;
+		std::vector<std::unique_ptr<llvm::TargetMachine>> idleMachines;
+	};
+};
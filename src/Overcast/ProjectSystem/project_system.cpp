@@ -1,5 +1,6 @@
 #include "ocpch.h"
 #include "project_system.h"
+#include "Overcast/oc_runtime.h"
 
 using namespace std::literals;
 
@@ -30,6 +31,18 @@ std::string Overcast::ProjectSystem::Project::SerializeTOML()
     buildFlags.insert("emit_llvm", emit_llvm);
     buildFlags.insert("no_autolink", skip_autolink);
     buildFlags.insert("OutputDirectory", outputFolder);
+    if (!OptLevel.empty())
+        buildFlags.insert("OptLevel", OptLevel);
+    if (!TargetCPU.empty())
+        buildFlags.insert("TargetCPU", TargetCPU);
+    if (!TargetFeatures.empty())
+        buildFlags.insert("TargetFeatures", TargetFeatures);
+    if (SplitModules > 1)
+        buildFlags.insert("SplitModules", SplitModules);
+    if (!LTO.empty())
+        buildFlags.insert("LTO", LTO);
+    if (WholeProgram)
+        buildFlags.insert("WholeProgram", WholeProgram);
 
     tbl.insert("BuildInfo", buildFlags);
     tbl.insert("Dependencies", deps);
@@ -66,10 +79,48 @@ Overcast::ProjectSystem::Project Overcast::ProjectSystem::Project::LoadFromTOML(
     p.emit_llvm = tbl["BuildInfo"]["emit_llvm"].as_boolean();
     p.skip_autolink = tbl["BuildInfo"]["no_autolink"].as_boolean();
     p.outputFolder = tbl["BuildInfo"]["OutputDirectory"].as_string()->get();
+    p.OptLevel = tbl["BuildInfo"]["OptLevel"].value_or("");
+    p.TargetCPU = tbl["BuildInfo"]["TargetCPU"].value_or("");
+    p.TargetFeatures = tbl["BuildInfo"]["TargetFeatures"].value_or("");
+    p.SplitModules = tbl["BuildInfo"]["SplitModules"].value_or(1);
+    p.LTO = tbl["BuildInfo"]["LTO"].value_or("");
+    p.WholeProgram = tbl["BuildInfo"]["WholeProgram"].value_or(false);
 
     return p;
 }
 
+Overcast::CodeGen::CodeGenOptions Overcast::ProjectSystem::Project::GetCodeGenOptions(const std::string& configuration) const
+{
+    Overcast::CodeGen::CodeGenOptions options;
+    if (configuration == "Debug")
+        options.Level = Overcast::CodeGen::OptLevel::O0;
+    else if (configuration == "Release")
+        options.Level = Overcast::CodeGen::OptLevel::O3;
+    else
+        throw std::runtime_error("Unknown build configuration " + configuration + ", expected Debug or Release.");
+
+    if (!OptLevel.empty())
+    {
+        auto level = Overcast::CodeGen::ParseOptLevel(OptLevel);
+        if (!level)
+            throw std::runtime_error("Invalid OptLevel " + OptLevel + " in the project file, expected one of O0/O1/O2/O3/Os/Oz.");
+        options.Level = *level;
+    }
+
+    if (!TargetCPU.empty())
+        options.CPU = TargetCPU;
+    options.Features = TargetFeatures;
+    options.SplitParts = static_cast<uint32_t>(std::max(1, SplitModules));
+
+    auto lto = Overcast::CodeGen::ParseLTOMode(LTO);
+    if (!lto)
+        throw std::runtime_error("Invalid LTO mode " + LTO + " in the project file, expected none or thin.");
+    options.LTO = *lto;
+    options.WholeProgram = WholeProgram;
+
+    return options;
+}
+
 std::shared_ptr<Overcast::ProjectSystem::BuildResult> Overcast::ProjectSystem::BuildProcess::Build()
 {
     try
@@ -104,6 +155,7 @@ std::shared_ptr<Overcast::ProjectSystem::BuildResult> Overcast::ProjectSystem::B
                 }
 
                 funcSymbol.Kind = Overcast::Semantic::Binder::SymbolKind::Function;
+                funcSymbol.IsExtern = funcDecl->IsExtern;
 
                 symbols[funcDecl->FuncName] = funcSymbol;
             }
@@ -111,7 +163,7 @@ std::shared_ptr<Overcast::ProjectSystem::BuildResult> Overcast::ProjectSystem::B
             {
                 Overcast::Semantic::Binder::Symbol strSymbol;
                 strSymbol.Name = structDecl->StructName;
-                strSymbol.Type = &IdentifierType{ structDecl->StructName };
+                strSymbol.Type = nullptr; // the global index gives structs their type
                 
                 for (const auto& structMember : structDecl->Members)
                 {
@@ -134,6 +186,7 @@ std::shared_ptr<Overcast::ProjectSystem::BuildResult> Overcast::ProjectSystem::B
                     for (const auto& p : structFunction->Parameters)
                     {
                         fSymbol.ParamTypeNames.push_back(p.ParameterType->to_string());
+                        fSymbol.ParamTypes.push_back(p.ParameterType.get());
                     }
 
                     strSymbol.StructSymbols.push_back(fSymbol);
@@ -213,7 +266,7 @@ bool clangExists() {
     return std::system(fallbackPath.c_str()) == 0;
 }
 
-Overcast::ProjectSystem::BuildResult Overcast::ProjectSystem::BuildSystem::RunBuild(std::string projectName, uint32_t numThreads)
+Overcast::ProjectSystem::BuildResult Overcast::ProjectSystem::BuildSystem::RunBuild(std::string projectName, const Overcast::CodeGen::CodeGenOptions& options, uint32_t numThreads)
 {
     std::vector<std::shared_ptr<BuildProcess>> nonDeps;
     std::vector<std::shared_ptr<BuildProcess>> deps;
@@ -285,7 +338,8 @@ Overcast::ProjectSystem::BuildResult Overcast::ProjectSystem::BuildSystem::RunBu
     threadPool.WaitAll();
 
     std::unordered_map<std::string, std::vector<std::unique_ptr<Statement>>> FileASTs;
-    std::unordered_map<std::string, Overcast::Semantic::Binder::Symbol> GlobalSymbolTable;
+    std::unordered_map<std::string, std::string> DefiningFiles; // function link name -> file
+    auto globalIndex = std::make_shared<Overcast::Semantic::Binder::GlobalSymbolIndex>();
     for (const auto& [path, future] : futures)
     {
         auto result = future.get();
@@ -296,26 +350,184 @@ Overcast::ProjectSystem::BuildResult Overcast::ProjectSystem::BuildSystem::RunBu
             std::cout << result->GetErrors() << std::endl; // not really an error, but
 
         FileASTs[path] = std::move(result->ASTresult);
-        for (const auto& symbols : result->GlobalSymbols)
+
+        // which file each function lives in, so calls from other files can be told apart after binding
+        for (const auto& [name, symbol] : result->GlobalSymbols)
+        {
+            if (symbol.Kind == Overcast::Semantic::Binder::SymbolKind::Function && !symbol.IsExtern)
+            {
+                DefiningFiles[Overcast::Semantic::Binder::MakeFunctionLinkName(symbol.Name, false)] = path;
+            }
+            else if (symbol.Kind == Overcast::Semantic::Binder::SymbolKind::Struct)
+            {
+                for (const auto& member : symbol.StructSymbols)
+                {
+                    if (member.Kind == Overcast::Semantic::Binder::SymbolKind::Function)
+                        DefiningFiles[Overcast::Semantic::Binder::MakeFunctionLinkName(member.Name, false, symbol.Name)] = path;
+                }
+            }
+        }
+
+        for (auto& symbols : result->GlobalSymbols)
         {
             if(symbols.first != "main")
-                GlobalSymbolTable[symbols.first] = symbols.second; // this shadows, but /w/
+                globalIndex->Add(std::move(symbols.second)); // this shadows, but /w/
         }
     }
 
-    std::filesystem::path cwd = std::filesystem::current_path();
+    globalIndex->Freeze();
+    std::shared_ptr<const Overcast::Semantic::Binder::GlobalSymbolIndex> GlobalSymbolTable = globalIndex;
 
+    // files only read the global table while binding, so they can all be bound at once
+    // the binders outlive codegen since the AST points into their symbols
+    std::unordered_map<std::string, std::unique_ptr<Overcast::Semantic::Binder::Binder>> FileBinders;
+    std::vector<std::shared_future<std::shared_ptr<BuildResult>>> bindFutures;
+    // whatever cores the files don't take up go to binding function bodies within each file
+    uint32_t bodyWorkers = std::max<uint32_t>(1, static_cast<uint32_t>(numThreads / std::max<size_t>(1, FileASTs.size())));
     for (const auto& fileAST : FileASTs)
     {
-        Overcast::Semantic::Binder::Binder binder(GlobalSymbolTable);
-        Overcast::CodeGen::CGEngine codeGen(fileAST.first);
+        const auto& path = fileAST.first;
+        const auto& statements = fileAST.second;
+        auto& binder = FileBinders[path];
+        binder = std::make_unique<Overcast::Semantic::Binder::Binder>(GlobalSymbolTable, bodyWorkers);
 
-        binder.Run(fileAST.second);
-        auto* module = codeGen.Generate(GlobalSymbolTable, fileAST.second);
+        bindFutures.push_back(threadPool.Submit([binder = binder.get(), &path, &statements]() -> std::shared_ptr<BuildResult> {
+            try
+            {
+                binder->Run(statements);
+            }
+            catch (std::exception& error)
+            {
+                return std::make_shared<BuildResult>(BuildResult::BuildState::FAILURE, path + "> " + error.what());
+            }
+            catch (...)
+            {
+                return std::make_shared<BuildResult>(BuildResult::BuildState::FAILURE, path + ">" + " Something went wrong during the build process.");
+            }
+
+            return std::make_shared<BuildResult>(BuildResult::BuildState::SUCCESS);
+            }));
+    }
+
+    // wait on every file before bailing, the tasks reference FileASTs
+    std::shared_ptr<BuildResult> bindFailure;
+    for (auto& future : bindFutures)
+    {
+        auto result = future.get();
+        if (!result->IsSuccess() && !bindFailure)
+            bindFailure = result;
+    }
+
+    for (const auto& fileAST : FileASTs)
+    {
+        for (const auto& warning : FileBinders[fileAST.first]->GetWarnings())
+            std::cerr << fileAST.first << "> warning: " << warning << std::endl;
+    }
 
-        //module->print(llvm::errs(), nullptr);
-        codeGen.EmitToObjectFile((cwd / "obj" / (std::filesystem::path(fileAST.first).filename().string() + ".obj")).string(), module);
-        std::cout << fileAST.first << " -> " << (std::filesystem::path(fileAST.first).filename().string() + ".obj") << std::endl;
+    if (bindFailure)
+        return { BuildResult::BuildState::FAILURE, bindFailure->GetErrors() };
+
+    // a function only has to stay external if another file calls it (or it's exported, codegen checks that)
+    std::unordered_set<std::string> CalledElsewhere;
+    for (const auto& [path, binder] : FileBinders)
+    {
+        for (const auto& linkName : binder->GetCalledFunctions())
+        {
+            auto it = DefiningFiles.find(linkName);
+            if (it == DefiningFiles.end() || it->second != path)
+                CalledElsewhere.insert(linkName);
+        }
+    }
+
+    std::filesystem::path cwd = std::filesystem::current_path();
+
+    auto objectName = [](const std::string& path) { return std::filesystem::path(path).filename().string() + ".obj"; };
+    auto programObjectName = projectName + ".obj";
+
+    if (options.WholeProgram)
+    {
+        // one engine for everything, files go in by path so the module doesn't depend on hash order
+        std::vector<std::string> paths;
+        for (const auto& fileAST : FileASTs)
+            paths.push_back(fileAST.first);
+        std::sort(paths.begin(), paths.end());
+
+        std::vector<const std::vector<std::unique_ptr<Statement>>*> files;
+        for (const auto& path : paths)
+            files.push_back(&FileASTs[path]);
+
+        try
+        {
+            Overcast::CodeGen::CGEngine codeGen(projectName, options);
+            auto* module = codeGen.GenerateProgram(*GlobalSymbolTable, files);
+
+            // objects from a per-file build would define everything a second time
+            for (const auto& path : paths)
+                Overcast::CodeGen::CGEngine::RemoveObjectFile((cwd / "obj" / objectName(path)).string());
+
+            codeGen.EmitToObjectFile((cwd / "obj" / programObjectName).string(), module);
+        }
+        catch (std::exception& error)
+        {
+            return { BuildResult::BuildState::FAILURE, projectName + "> " + error.what() };
+        }
+        catch (...)
+        {
+            return { BuildResult::BuildState::FAILURE, projectName + ">" + " Something went wrong during the build process." };
+        }
+
+        std::cout << paths.size() << " files -> " << programObjectName << std::endl;
+    }
+    else
+    {
+        Overcast::CodeGen::CGEngine::RemoveObjectFile((cwd / "obj" / programObjectName).string());
+
+        // every file gets its own engine and with it its own LLVMContext, so generating, optimizing and emitting
+        // them all at once is safe, they only share the (frozen) global table and their own ASTs
+        std::mutex coutMutex;
+        std::vector<std::shared_future<std::shared_ptr<BuildResult>>> codeGenFutures;
+        for (const auto& fileAST : FileASTs)
+        {
+            codeGenFutures.push_back(threadPool.Submit([&fileAST, &cwd, &options, &coutMutex, &GlobalSymbolTable, &CalledElsewhere, &objectName]() -> std::shared_ptr<BuildResult> {
+                const auto& path = fileAST.first;
+                auto objectFile = objectName(path);
+                try
+                {
+                    Overcast::CodeGen::CGEngine codeGen(path, options);
+
+                    auto* module = codeGen.Generate(*GlobalSymbolTable, fileAST.second, CalledElsewhere);
+
+                    //module->print(llvm::errs(), nullptr);
+                    codeGen.EmitToObjectFile((cwd / "obj" / objectFile).string(), module);
+                }
+                catch (std::exception& error)
+                {
+                    return std::make_shared<BuildResult>(BuildResult::BuildState::FAILURE, path + "> " + error.what());
+                }
+                catch (...)
+                {
+                    return std::make_shared<BuildResult>(BuildResult::BuildState::FAILURE, path + ">" + " Something went wrong during the build process.");
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(coutMutex);
+                    std::cout << path << " -> " << objectFile << std::endl;
+                }
+                return std::make_shared<BuildResult>(BuildResult::BuildState::SUCCESS);
+                }));
+        }
+
+        // same as binding, everything has to finish before the ASTs can go away
+        std::shared_ptr<BuildResult> codeGenFailure;
+        for (auto& future : codeGenFutures)
+        {
+            auto result = future.get();
+            if (!result->IsSuccess() && !codeGenFailure)
+                codeGenFailure = result;
+        }
+
+        if (codeGenFailure)
+            return { BuildResult::BuildState::FAILURE, codeGenFailure->GetErrors() };
     }
 
 #ifdef _WIN32
@@ -335,9 +547,36 @@ Overcast::ProjectSystem::BuildResult Overcast::ProjectSystem::BuildSystem::RunBu
         }
     }
 
+    // the runtime gets compiled along with the link, at the project's opt level
+    auto runtimeSource = cwd / "obj" / "oc_runtime.c";
+    {
+        std::ofstream runtimeFile(runtimeSource, std::ios::trunc);
+        if (!runtimeFile)
+            return { BuildResult::BuildState::FAILURE, "failed to write " + runtimeSource.string() };
+        runtimeFile << OC_RUNTIME_SOURCE;
+    }
+    allFiles += runtimeSource.string() + " ";
+
+    static const char* levelFlags[] = { "-O0", "-O1", "-O2", "-O3", "-Os", "-Oz" }; // same order as OptLevel
+    std::string linkFlags = std::string(levelFlags[static_cast<int>(options.Level)]) + " ";
+#ifndef _WIN32
+    linkFlags += "-pthread "; // the runtime drains each thread's output through a pthread key
+#endif
+    if (options.LTO == Overcast::CodeGen::LTOMode::Thin)
+    {
+        // lld runs the thin lto backends in-process and in parallel, and the cache lets it skip modules that didn't change
+        auto cacheDir = (cwd / "obj" / "thinlto-cache").string();
+        linkFlags += "-flto=thin -fuse-ld=lld ";
+#ifdef _WIN32
+        linkFlags += "-Wl,/lldltocache:\"" + cacheDir + "\" ";
+#else
+        linkFlags += "-Wl,--thinlto-cache-dir=\"" + cacheDir + "\" ";
+#endif
+    }
+
     if (clangExists())
     {
-        std::string cmd = "clang " + allFiles + "-o bin/" + projectName + exeExt;
+        std::string cmd = "clang " + linkFlags + allFiles + "-o bin/" + projectName + exeExt;
         if (std::system(cmd.c_str()) == EXIT_FAILURE)
         {
             std::cerr << "Failed to link project" << std::endl;
@@ -94,8 +94,16 @@ namespace Overcast::ProjectSystem
 		bool skip_autolink = false;
 
 		std::string outputFolder;
+		std::string OptLevel; // overrides the configuration's level when set
+		std::string TargetCPU; // generic when empty, "native" builds for this machine
+		std::string TargetFeatures;
+		int SplitModules = 1; // parts each file's module is split into for the backend
+		std::string LTO; // "thin" links with thin lto, empty or "none" doesn't
+		bool WholeProgram = false;
 
 		std::string SerializeTOML();
+		// Debug builds at O0 and Release at O3 unless the project says otherwise
+		Overcast::CodeGen::CodeGenOptions GetCodeGenOptions(const std::string& configuration) const;
 		static Project LoadFromTOML(std::string toml);
 	};
 
@@ -188,6 +196,6 @@ namespace Overcast::ProjectSystem
 		std::unordered_map<std::string, std::vector<std::string>> dependencies;
 	public:
 		void AddBuildFile(const std::string& file, const std::vector<std::string>& deps);
-		BuildResult RunBuild(std::string projectName, uint32_t numThreads = std::thread::hardware_concurrency());
+		BuildResult RunBuild(std::string projectName, const Overcast::CodeGen::CodeGenOptions& options = {}, uint32_t numThreads = std::thread::hardware_concurrency());
 	};
 };
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "ocpch.h"
+#include "attribute_inference.h"
+
+void Overcast::Semantic::AttributeInference::Run(FunctionDeclStatement& funcDecl, const StructLookup& findStruct)
+{
+	AttributeInference inference;
+	auto& result = inference.Result;
+	result.ReadsMemory = false;
+	result.WritesMemory = false;
+	result.CallsFunctions = false;
+	result.CallsBuiltins = false;
+	result.HasLoops = false;
+
+	inference.VisitBlock(funcDecl.Body);
+
+	// there are no globals to write and 'this' is the only way to get a pointer, so a pointer parameter can only
+	// alias something else the function can reach if there's another pointer (or struct that could hold one) next to it,
+	// or the object itself has pointers in it
+	size_t pointerParams = 0;
+	bool othersHoldPointers = false;
+	for (const auto& param : funcDecl.Parameters)
+	{
+		if (dynamic_cast<PointerType*>(param.ParameterType.get()))
+			pointerParams++;
+		else if (!HoldsNoPointers(*param.ParameterType, findStruct))
+			othersHoldPointers = true;
+	}
+
+	result.NoAliasParams.assign(funcDecl.Parameters.size(), false);
+	for (size_t i = 0; i < funcDecl.Parameters.size(); i++)
+	{
+		auto pointer = dynamic_cast<PointerType*>(funcDecl.Parameters[i].ParameterType.get());
+		if (!pointer || pointerParams != 1 || othersHoldPointers)
+			continue;
+
+		result.NoAliasParams[i] = HoldsNoPointers(*pointer->OfType, findStruct);
+	}
+
+	funcDecl.Inferred = std::move(result);
+}
+
+void Overcast::Semantic::AttributeInference::VisitBlock(const std::vector<std::unique_ptr<Statement>>& block)
+{
+	for (const auto& stmt : block)
+	{
+		VisitStatement(*stmt);
+	}
+}
+
+void Overcast::Semantic::AttributeInference::VisitStatement(const Statement& stmt)
+{
+	switch (stmt.m_Type)
+	{
+	case Statement::Type::VariableDecl:
+	{
+		const auto& varDecl = static_cast<const VariableDeclStatement&>(stmt);
+		if (varDecl.Defined && varDecl.DefaultValue)
+			VisitExpression(*varDecl.DefaultValue);
+		break;
+	}
+	case Statement::Type::Assignment:
+	{
+		const auto& assign = static_cast<const AssignmentStatement&>(stmt);
+		if (!dynamic_cast<const VariableUseExpr*>(assign.LHS.get()))
+			Result.WritesMemory = true; // a field, possibly through 'this'
+		VisitExpression(*assign.LHS);
+		VisitExpression(*assign.Value);
+		break;
+	}
+	case Statement::Type::CompoundAssignment:
+	{
+		const auto& assign = static_cast<const CompoundAssignmentStatement&>(stmt);
+		if (!dynamic_cast<const VariableUseExpr*>(assign.LHS.get()))
+		{
+			Result.ReadsMemory = true;
+			Result.WritesMemory = true;
+		}
+		VisitExpression(*assign.LHS);
+		VisitExpression(*assign.Value);
+		break;
+	}
+	case Statement::Type::Expression:
+		VisitExpression(*static_cast<const ExpressionStatement&>(stmt).EncapsulatedExpr);
+		break;
+	case Statement::Type::Return:
+	{
+		const auto& retStmt = static_cast<const ReturnStatement&>(stmt);
+		if (retStmt.ReturnValue)
+			VisitExpression(*retStmt.ReturnValue);
+		break;
+	}
+	case Statement::Type::If:
+	{
+		const auto& ifStmt = static_cast<const IfStatement&>(stmt);
+		VisitExpression(*ifStmt.Condition);
+		VisitBlock(ifStmt.Body);
+		VisitBlock(ifStmt.ElseBody);
+		break;
+	}
+	case Statement::Type::While:
+	{
+		const auto& whStmt = static_cast<const WhileStatement&>(stmt);
+		Result.HasLoops = true;
+		VisitExpression(*whStmt.Condition);
+		VisitBlock(whStmt.Body);
+		break;
+	}
+	case Statement::Type::For:
+	{
+		const auto& forStmt = static_cast<const ForStatement&>(stmt);
+		Result.HasLoops = true;
+		if (forStmt.Init)
+			VisitStatement(*forStmt.Init);
+		if (forStmt.Condition)
+			VisitExpression(*forStmt.Condition);
+		if (forStmt.Step)
+			VisitStatement(*forStmt.Step);
+		VisitBlock(forStmt.Body);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void Overcast::Semantic::AttributeInference::VisitExpression(const Expression& expr)
+{
+	if (expr.IsConstant)
+		return;
+
+	if (auto varExpr = dynamic_cast<const VariableUseExpr*>(&expr))
+	{
+		if (varExpr->ResolvedSymbol && varExpr->ResolvedSymbol->ConstObject)
+			Result.ReadsMemory = true; // struct consts live in a global
+	}
+	else if (auto binExpr = dynamic_cast<const BinaryExpr*>(&expr))
+	{
+		VisitExpression(*binExpr->A);
+		VisitExpression(*binExpr->B);
+	}
+	else if (auto strAccExpr = dynamic_cast<const StructAccessExpr*>(&expr))
+	{
+		Result.ReadsMemory = true;
+		VisitExpression(*strAccExpr->LHS);
+	}
+	else if (auto funcCall = dynamic_cast<const InvokeFunctionExpr*>(&expr))
+	{
+		if (funcCall->ResolvedSymbol && funcCall->ResolvedSymbol->IsBuiltin)
+		{
+			Result.CallsBuiltins = true;
+			Result.WritesMemory = true; // print and flush both go through the runtime's buffer
+		}
+		else
+		{
+			Result.CallsFunctions = true;
+			Result.ReadsMemory = true;
+			Result.WritesMemory = true;
+		}
+
+		for (const auto& arg : funcCall->Arguments)
+		{
+			VisitExpression(*arg);
+		}
+
+		if (auto method = dynamic_cast<const StructAccessExpr*>(funcCall->InvokedFunction.get()))
+			VisitExpression(*method->LHS);
+	}
+	else if (auto ctorExpr = dynamic_cast<const StructCtorExpr*>(&expr))
+	{
+		if (ctorExpr->Escapes)
+			Result.WritesMemory = true; // malloc
+		if (ctorExpr->ResolvedCtor)
+		{
+			Result.CallsFunctions = true;
+			Result.ReadsMemory = true;
+			Result.WritesMemory = true;
+		}
+
+		for (const auto& arg : ctorExpr->Arguments)
+		{
+			VisitExpression(*arg);
+		}
+	}
+}
+
+bool Overcast::Semantic::AttributeInference::HoldsNoPointers(const OCType& type, const StructLookup& findStruct)
+{
+	if (dynamic_cast<const PointerType*>(&type))
+		return false;
+
+	const auto typeName = type.to_string();
+	if (typeName == "int" || typeName == "bool" || typeName == "float" || typeName == "string")
+		return true;
+
+	// structs inside structs are stored inline, so look through them too (a struct can't contain itself by value)
+	const Binder::Symbol* structSymbol = findStruct(typeName);
+	if (!structSymbol || structSymbol->Kind != Binder::SymbolKind::Struct)
+		return false;
+
+	for (const auto& member : structSymbol->StructSymbols)
+	{
+		if (member.Kind == Binder::SymbolKind::Variable && !HoldsNoPointers(*member.Type, findStruct))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <functional>
+#include <string>
+#include "Overcast/SyntaxAnalysis/statements.h"
+#include "Overcast/SyntaxAnalysis/expressions.h"
+#include "symbol_table.h"
+
+namespace Overcast::Semantic
+{
+	// fills in FunctionDeclStatement::Inferred from one bound body, run it after the escape analysis
+	// callees aren't looked at (their bodies may be bound on another thread), so any call is assumed to do anything
+	class AttributeInference
+	{
+	public:
+		using StructLookup = std::function<const Binder::Symbol*(const std::string&)>;
+
+		static void Run(FunctionDeclStatement& funcDecl, const StructLookup& findStruct);
+
+		// only structs of plain values, so a pointer to one can't lead to any other object
+		static bool HoldsNoPointers(const OCType& type, const StructLookup& findStruct);
+	private:
+		FunctionDeclStatement::InferredAttributes Result;
+
+		void VisitBlock(const std::vector<std::unique_ptr<Statement>>& block);
+		void VisitStatement(const Statement& stmt);
+		void VisitExpression(const Expression& expr);
+	};
+}
@@ -1,29 +1,42 @@
 #include "ocpch.h"
 #include "ocutils.h"
 #include "binder.h"
+#include "const_evaluator.h"
+#include "interpreter.h"
+#include "escape_analysis.h"
+#include "attribute_inference.h"
+#include <future>
 
-void Overcast::Semantic::Binder::Binder::BindStatement(const Statement& stmt)
+void Overcast::Semantic::Binder::Binder::BindStatement(Statement& stmt)
 {
+	CheckAttributes(stmt);
+
 	switch (stmt.m_Type)
 	{
 	case Statement::Type::FunctionDecl:
 	{
-		const FunctionDeclStatement& funcDecl = static_cast<const FunctionDeclStatement&>(stmt);
+		FunctionDeclStatement& funcDecl = static_cast<FunctionDeclStatement&>(stmt);
 		BindFunctionDecl(funcDecl);
 		break;
 	}
 	case Statement::Type::StructDecl:
 	{
-		const StructDeclStatement& strDecl = static_cast<const StructDeclStatement&>(stmt);
+		StructDeclStatement& strDecl = static_cast<StructDeclStatement&>(stmt);
 		BindStructDecl(strDecl);
 		break;
 	}
 	case Statement::Type::VariableDecl:
 	{
-		const VariableDeclStatement& varDecl = static_cast<const VariableDeclStatement&>(stmt);
+		VariableDeclStatement& varDecl = static_cast<VariableDeclStatement&>(stmt);
 		BindVariableDecl(varDecl);
 		break;
 	}
+	case Statement::Type::ConstDecl:
+	{
+		ConstDeclStatement& constDecl = static_cast<ConstDeclStatement&>(stmt);
+		BindConstDecl(constDecl);
+		break;
+	}
 	case Statement::Type::Expression:
 	{
 		const ExpressionStatement& exprStmt = static_cast<const ExpressionStatement&>(stmt);
@@ -33,23 +46,39 @@ void Overcast::Semantic::Binder::Binder::BindStatement(const Statement& stmt)
 	case Statement::Type::Assignment:
 	{
 		const AssignmentStatement& assgStmt = static_cast<const AssignmentStatement&>(stmt);
-		Symbol varSymbol = BindExpression(*assgStmt.LHS);
+		const Symbol* varSymbol = BindAssignmentTarget(*assgStmt.LHS);
+
+		const Symbol* valueSymbol = this->BindExpression(*assgStmt.Value);
+		if (valueSymbol->Type->to_string() != varSymbol->Type->to_string())
+		{
+			throw std::runtime_error("Type mismatch in value assignment: expected " + varSymbol->Type->to_string() +
+				", but got " + valueSymbol->Type->to_string() + ".");
+		}
+		break;
+	}
+	case Statement::Type::CompoundAssignment:
+	{
+		const CompoundAssignmentStatement& assgStmt = static_cast<const CompoundAssignmentStatement&>(stmt);
+		const Symbol* varSymbol = BindAssignmentTarget(*assgStmt.LHS);
+		if (varSymbol->Type->to_string() != "int")
+		{
+			throw std::runtime_error("Operator " + assgStmt.Operator + "= needs an int to assign to, but got " + varSymbol->Type->to_string() + ".");
+		}
 
-		Symbol valueSymbol = this->BindExpression(*assgStmt.Value);
-		if (valueSymbol.Type->to_string() != varSymbol.Type->to_string())
+		const Symbol* valueSymbol = this->BindExpression(*assgStmt.Value);
+		if (valueSymbol->Type->to_string() != "int")
 		{
-			throw std::runtime_error("Type mismatch in value assignment: expected " + varSymbol.Type->to_string() +
-				", but got " + valueSymbol.Type->to_string() + ".");
+			throw std::runtime_error("Type mismatch in value assignment: expected int, but got " + valueSymbol->Type->to_string() + ".");
 		}
 		break;
 	}
 	case Statement::Type::If:
 	{
 		const IfStatement& ifStmt = static_cast<const IfStatement&>(stmt);
-		auto& conditionSymbol = this->BindExpression(*ifStmt.Condition);
-		if (conditionSymbol.Type->to_string() != "bool")
+		const Symbol* conditionSymbol = this->BindExpression(*ifStmt.Condition);
+		if (conditionSymbol->Type->to_string() != "bool")
 		{
-			throw std::runtime_error("Condition in if statement must be of type bool, but got " + conditionSymbol.Type->to_string() + ".");
+			throw std::runtime_error("Condition in if statement must be of type bool, but got " + conditionSymbol->Type->to_string() + ".");
 		}
 		for (const auto& bodyStmt : ifStmt.Body)
 		{
@@ -67,10 +96,10 @@ void Overcast::Semantic::Binder::Binder::BindStatement(const Statement& stmt)
 	case Statement::Type::While:
 	{
 		const WhileStatement& whStmt = static_cast<const WhileStatement&>(stmt);
-		auto& conditionSymbol = this->BindExpression(*whStmt.Condition);
-		if (conditionSymbol.Type->to_string() != "bool")
+		const Symbol* conditionSymbol = this->BindExpression(*whStmt.Condition);
+		if (conditionSymbol->Type->to_string() != "bool")
 		{
-			throw std::runtime_error("Condition in while statement must be of type bool, but got " + conditionSymbol.Type->to_string() + ".");
+			throw std::runtime_error("Condition in while statement must be of type bool, but got " + conditionSymbol->Type->to_string() + ".");
 		}
 		for (const auto& bodyStmt : whStmt.Body)
 		{
@@ -78,24 +107,51 @@ void Overcast::Semantic::Binder::Binder::BindStatement(const Statement& stmt)
 		}
 		break;
 	}
+	case Statement::Type::For:
+	{
+		const ForStatement& forStmt = static_cast<const ForStatement&>(stmt);
+		this->EnterScope(); // the loop var is gone after the loop
+		if (forStmt.Init)
+		{
+			this->BindStatement(*forStmt.Init);
+		}
+		if (forStmt.Condition)
+		{
+			const Symbol* conditionSymbol = this->BindExpression(*forStmt.Condition);
+			if (conditionSymbol->Type->to_string() != "bool")
+			{
+				throw std::runtime_error("Condition in for statement must be of type bool, but got " + conditionSymbol->Type->to_string() + ".");
+			}
+		}
+		if (forStmt.Step)
+		{
+			this->BindStatement(*forStmt.Step);
+		}
+		for (const auto& bodyStmt : forStmt.Body)
+		{
+			this->BindStatement(*bodyStmt);
+		}
+		this->ExitScope();
+		break;
+	}
 	case Statement::Type::Return:
 	{
 		const ReturnStatement& retStmt = static_cast<const ReturnStatement&>(stmt);
-		if (!CurrentFunction.Type || CurrentFunction.Type->to_string() == "void")
+		if (!CurrentFunction)
 		{
-			throw std::runtime_error("Return statement found in a function that does not return a value.");
+			throw std::runtime_error("Return statement found outside of a function context.");
 		}
-		if (CurrentFunction.Name == "<INVALID>")
+		if (!CurrentFunction->Type || CurrentFunction->Type->to_string() == "void")
 		{
-			throw std::runtime_error("Return statement found outside of a function context.");
+			throw std::runtime_error("Return statement found in a function that does not return a value.");
 		}
 		if (retStmt.ReturnValue)
 		{
-			auto& returnSymbol = this->BindExpression(*retStmt.ReturnValue);
-			if (returnSymbol.Type->to_string() != CurrentFunction.Type->to_string())
+			const Symbol* returnSymbol = this->BindExpression(*retStmt.ReturnValue);
+			if (returnSymbol->Type->to_string() != CurrentFunction->Type->to_string())
 			{
-				throw std::runtime_error("Return type mismatch in function " + CurrentFunction.Name + ": expected " +
-					CurrentFunction.Type->to_string() + ", but got " + returnSymbol.Type->to_string() + ".");
+				throw std::runtime_error("Return type mismatch in function " + CurrentFunction->Name + ": expected " +
+					CurrentFunction->Type->to_string() + ", but got " + returnSymbol->Type->to_string() + ".");
 			}
 		}
 		break;
@@ -112,75 +168,217 @@ void Overcast::Semantic::Binder::Binder::BindStatement(const Statement& stmt)
 	}
 }
 
-void Overcast::Semantic::Binder::Binder::BindFunctionDecl(const FunctionDeclStatement& funcDecl)
+void Overcast::Semantic::Binder::Binder::BindFunctionDecl(FunctionDeclStatement& funcDecl)
 {
-	Symbol funcSymbol(funcDecl.FuncName, SymbolKind::Function, funcDecl.ReturnType.get());
-	funcSymbol.ParamCount = funcDecl.Parameters.size();
+	const Symbol* declaredSymbol = funcDecl.ResolvedSymbol; // struct members were already resolved by BindStructDecl
 
-	for (const auto& param : funcDecl.Parameters)
+	if (!declaredSymbol)
 	{
-		funcSymbol.ParamTypeNames.push_back(param.ParameterType->to_string());
-	}
-
-	bool passAdd = false;
+		Symbol funcSymbol(funcDecl.FuncName, SymbolKind::Function, funcDecl.ReturnType.get());
+		funcSymbol.ParamCount = funcDecl.Parameters.size();
+		funcSymbol.IsExtern = funcDecl.IsExtern;
+		funcSymbol.LinkName = MakeFunctionLinkName(funcDecl.FuncName, funcDecl.IsExtern);
 
-	Symbol existingSymbol;
-	if (LookupSymbol(funcDecl.FuncName, existingSymbol))
-	{
-		// if the sigs match, then prob just global table conflict:
-		if (funcDecl.Parameters.size() != existingSymbol.ParamTypes.size() && !existingSymbol.IsStructMemberFunc) // obv no match
+		for (const auto& param : funcDecl.Parameters)
 		{
-			throw std::runtime_error("Function " + funcDecl.FuncName + " is already defined in this module.");
+			funcSymbol.ParamTypeNames.push_back(param.ParameterType->to_string());
+			funcSymbol.ParamTypes.push_back(param.ParameterType.get());
 		}
 
-		bool noMatch = true;
-		int idx = 0;
-		for (const auto& param : existingSymbol.ParamTypes)
+		bool passAdd = false;
+
+		const Symbol* existingSymbol = LookupSymbol(funcDecl.FuncName);
+		if (existingSymbol && existingSymbol->IsBuiltin) // the user's function shadows it
+			existingSymbol = nullptr;
+		if (existingSymbol)
 		{
-			if (param->to_string() != funcDecl.Parameters[idx].ParameterType->to_string())
+			// if the sigs match, then prob just global table conflict:
+			if (funcDecl.Parameters.size() != existingSymbol->ParamTypes.size() && !existingSymbol->IsStructMemberFunc) // obv no match
+			{
+				throw std::runtime_error("Function " + funcDecl.FuncName + " is already defined in this module.");
+			}
+
+			bool noMatch = true;
+			int idx = 0;
+			for (const auto& param : existingSymbol->ParamTypes)
+			{
+				if (param->to_string() != funcDecl.Parameters[idx].ParameterType->to_string())
+				{
+					noMatch = false;
+				}
+				idx++;
+			}
+
+			if (noMatch)
 			{
-				noMatch = false;
+				passAdd = true;
 			}
-			idx++;
+
+			if (!passAdd)
+				throw std::runtime_error("Function " + funcDecl.FuncName + " is already defined in this module.");
+		}
+
+		// when it's the global table's entry for this very function, calls resolve to that one
+		declaredSymbol = passAdd ? existingSymbol : DeclareSymbol(std::move(funcSymbol));
+		funcDecl.ResolvedSymbol = declaredSymbol;
+	}
+
+	if (!FileBinder && !funcDecl.IsConstFunc && !funcDecl.IsStructMember) // top level, the body waits until every global in the file is declared
+	{
+		PendingBodies.push_back(&funcDecl);
+		return;
+	}
+
+	if (!FileBinder) // the interpreter may need it for a const, so it's bound now, by a binder of its own so the file scope stays at the top
+	{
+		CompileTimeBinders.push_back(std::unique_ptr<Binder>(new Binder(this, this)));
+		auto& bodyBinder = *CompileTimeBinders.back();
+		bodyBinder.BindFunctionBody(funcDecl);
+		CalledFunctions.insert(bodyBinder.CalledFunctions.begin(), bodyBinder.CalledFunctions.end());
+		Warnings.insert(Warnings.end(), bodyBinder.Warnings.begin(), bodyBinder.Warnings.end());
+	}
+	else
+	{
+		BindFunctionBody(funcDecl);
+	}
+	if (funcDecl.IsConstFunc || funcDecl.IsStructMember)
+		CompileTimeBodies.insert({ funcDecl.ResolvedSymbol->LinkName, &funcDecl });
+}
+
+void Overcast::Semantic::Binder::Binder::IndexCompileTimeDecls(const std::vector<std::unique_ptr<Statement>>& statements)
+{
+	for (const auto& statement : statements)
+	{
+		if (statement->m_Type == Statement::Type::FunctionDecl)
+		{
+			const auto& funcDecl = static_cast<const FunctionDeclStatement&>(*statement);
+			if (funcDecl.IsConstFunc)
+				CompileTimeDecls.insert({ MakeFunctionLinkName(funcDecl.FuncName, funcDecl.IsExtern), statement.get() });
+		}
+		else if (statement->m_Type == Statement::Type::StructDecl)
+		{
+			const auto& structDecl = static_cast<const StructDeclStatement&>(*statement);
+			for (const auto& memberFunc : structDecl.MemberFunctions)
+				CompileTimeDecls.insert({ MakeFunctionLinkName(memberFunc->FuncName, false, structDecl.StructName), statement.get() });
 		}
+	}
+}
+
+const FunctionDeclStatement* Overcast::Semantic::Binder::Binder::RequireCompileTimeBody(const Symbol* funcSymbol)
+{
+	if (auto body = FindCompileTimeBody(funcSymbol))
+		return body;
+
+	// only during the global pass, after it every compile-time body is bound anyway
+	Binder* fileBinder = FileBinder ? Owner : this;
+	if (!fileBinder)
+		return nullptr;
+
+	auto it = fileBinder->CompileTimeDecls.find(funcSymbol->LinkName);
+	if (it == fileBinder->CompileTimeDecls.end() || !fileBinder->BoundStatements.insert(it->second).second) // not ours, or already being bound
+		return nullptr;
+
+	fileBinder->BindStatement(*it->second);
+	return FindCompileTimeBody(funcSymbol);
+}
+
+const Overcast::Semantic::Binder::Symbol* Overcast::Semantic::Binder::Binder::BindAssignmentTarget(Expression& target)
+{
+	const Symbol* varSymbol = BindExpression(target);
 
-		if (noMatch)
+	// writing a field of a const struct is writing the const too
+	const Expression* root = &target;
+	while (auto strAcc = dynamic_cast<const StructAccessExpr*>(root))
+		root = strAcc->LHS.get();
+	const Symbol* rootSymbol = root->ResolvedSymbol ? root->ResolvedSymbol : varSymbol;
+	if (varSymbol->IsConst || rootSymbol->IsConst)
+	{
+		throw std::runtime_error("Cannot assign to constant " + rootSymbol->Name + ".");
+	}
+	return varSymbol;
+}
+
+void Overcast::Semantic::Binder::Binder::CheckAttributes(const Statement& stmt)
+{
+	struct AttributeRule
+	{
+		Statement::Type Target;
+		const char* Name;
+		size_t Arguments;
+	};
+	static const AttributeRule rules[] = {
+		{ Statement::Type::FunctionDecl, "inline", 0 },
+		{ Statement::Type::FunctionDecl, "noinline", 0 },
+		{ Statement::Type::While, "vectorize", 1 },
+		{ Statement::Type::While, "unroll", 1 },
+		{ Statement::Type::For, "vectorize", 1 },
+		{ Statement::Type::For, "unroll", 1 },
+	};
+
+	for (const auto& attribute : stmt.Attributes)
+	{
+		auto rule = std::find_if(std::begin(rules), std::end(rules), [&](const AttributeRule& r) { return r.Target == stmt.m_Type && attribute.Name == r.Name; });
+		if (rule == std::end(rules))
+		{
+			throw std::runtime_error("#" + attribute.Name + " can't be used here.");
+		}
+		if (attribute.Arguments.size() != rule->Arguments)
 		{
-			passAdd = true;
+			throw std::runtime_error("#" + attribute.Name + " takes " + std::to_string(rule->Arguments) + " arguments, but got " + std::to_string(attribute.Arguments.size()) + ".");
 		}
+	}
 
-		if(!funcDecl.IsStructMember && !passAdd)
-			throw std::runtime_error("Function " + funcDecl.FuncName + " is already defined in this module.");
+	if (stmt.FindAttribute("inline") && stmt.FindAttribute("noinline"))
+	{
+		throw std::runtime_error("A function can't be both #inline and #noinline.");
 	}
 
-	if (!funcDecl.IsStructMember && !passAdd)
-		this->Scopes.back().AddSymbol(funcSymbol);
+	// #vectorize(1) and #unroll(1) turn them off, the vectorizer only does power of two widths
+	if (auto vectorize = stmt.FindAttribute("vectorize"))
+	{
+		auto width = vectorize->Arguments[0];
+		if (width < 1 || (width & (width - 1)) != 0)
+		{
+			throw std::runtime_error("#vectorize needs a power of two width, but got " + std::to_string(width) + ".");
+		}
+	}
+	if (auto unroll = stmt.FindAttribute("unroll"))
+	{
+		if (unroll->Arguments[0] < 1)
+		{
+			throw std::runtime_error("#unroll needs a count of at least 1, but got " + std::to_string(unroll->Arguments[0]) + ".");
+		}
+	}
+}
 
+void Overcast::Semantic::Binder::Binder::BindFunctionBody(FunctionDeclStatement& funcDecl)
+{
 	this->EnterScope();
 
-	for (const auto& param : funcDecl.Parameters)
+	for (auto& param : funcDecl.Parameters)
 	{
-		Symbol paramSymbol(param.ParameterName, SymbolKind::Variable, param.ParameterType.get());
-		this->Scopes.back().AddSymbol(paramSymbol);
+		param.ResolvedSymbol = DeclareSymbol(Symbol(param.ParameterName, SymbolKind::Variable, param.ParameterType.get()));
 	}
 
-	CurrentFunction = funcSymbol;
+	CurrentFunction = funcDecl.ResolvedSymbol;
 
 	for (const auto& statement : funcDecl.Body)
 	{
 		this->BindStatement(*statement);
 	}
 
-	CurrentFunction = Symbol("<INVALID>", SymbolKind::Function, nullptr);
+	CurrentFunction = nullptr;
 
 	this->ExitScope();
+
+	auto findStruct = [this](const std::string& name) { return LookupSymbol(name); };
+	EscapeAnalysis::Run(funcDecl, findStruct);
+	AttributeInference::Run(funcDecl, findStruct);
 }
 
-void Overcast::Semantic::Binder::Binder::BindVariableDecl(const VariableDeclStatement& varDecl)
+void Overcast::Semantic::Binder::Binder::BindVariableDecl(VariableDeclStatement& varDecl)
 {
-	Symbol varSymbol(varDecl.VarName, SymbolKind::Variable, varDecl.VariableType.get());
-	Symbol existingSymbol;
-	if (this->Scopes.back().TryGetSymbol(varDecl.VarName, existingSymbol))
+	if (this->Scopes.IsBoundInCurrentScope(varDecl.VarName))
 	{
 		throw std::runtime_error("Variable " + varDecl.VarName + " is already defined in this scope.");
 	}
@@ -192,22 +390,77 @@ void Overcast::Semantic::Binder::Binder::BindVariableDecl(const VariableDeclStat
 
 	if (varDecl.Defined)
 	{
-		auto& exSymbol = BindExpression(*varDecl.DefaultValue);
-		if (exSymbol.Type->to_string() != varDecl.VariableType->to_string())
+		const Symbol* exSymbol = BindExpression(*varDecl.DefaultValue);
+		if (exSymbol->Type->to_string() != varDecl.VariableType->to_string())
 		{
 			throw std::runtime_error("Variable " + varDecl.VarName + " is initialized with type " +
-				exSymbol.Type->to_string() + ", but expected type is " + varDecl.VariableType->to_string() + ".");
+				exSymbol->Type->to_string() + ", but expected type is " + varDecl.VariableType->to_string() + ".");
+		}
+	}
+
+	varDecl.ResolvedSymbol = DeclareSymbol(Symbol(varDecl.VarName, SymbolKind::Variable, varDecl.VariableType.get()));
+}
+
+void Overcast::Semantic::Binder::Binder::BindConstDecl(ConstDeclStatement& constDecl)
+{
+	if (this->Scopes.IsBoundInCurrentScope(constDecl.VarName))
+	{
+		throw std::runtime_error("Constant " + constDecl.VarName + " is already defined in this scope.");
+	}
+
+	const auto typeName = constDecl.VariableType->to_string();
+	const Symbol* typeSymbol = LookupSymbol(typeName);
+	bool isStruct = typeSymbol && typeSymbol->Kind == SymbolKind::Struct;
+	if (typeName != "int" && typeName != "bool" && !isStruct)
+	{
+		throw std::runtime_error("Constant " + constDecl.VarName + " has type " + typeName + ", but only int, bool and struct constants are supported.");
+	}
+
+	const Symbol* exSymbol = BindExpression(*constDecl.DefaultValue);
+	if (exSymbol->Type->to_string() != typeName)
+	{
+		throw std::runtime_error("Constant " + constDecl.VarName + " is initialized with type " +
+			exSymbol->Type->to_string() + ", but expected type is " + typeName + ".");
+	}
+
+	Symbol constSymbol(constDecl.VarName, SymbolKind::Variable, constDecl.VariableType.get());
+	constSymbol.IsConst = true;
+
+	if (!constDecl.DefaultValue->IsConstant) // not foldable on its own, so run it (const func calls, struct construction)
+	{
+		Interpreter interpreter(
+			[this](const Symbol* funcSymbol) { return RequireCompileTimeBody(funcSymbol); },
+			[this](const std::string& name) { return LookupSymbol(name); });
+
+		ConstValue value;
+		try
+		{
+			value = interpreter.Evaluate(*constDecl.DefaultValue);
+		}
+		catch (std::runtime_error& error)
+		{
+			throw std::runtime_error("Constant " + constDecl.VarName + " is not a compile-time constant: " + error.what());
+		}
+
+		if (isStruct)
+		{
+			constSymbol.ConstObject = std::make_shared<const ConstValue>(std::move(value));
+		}
+		else
+		{
+			constDecl.DefaultValue->IsConstant = true;
+			constDecl.DefaultValue->ConstantValue = value.Int;
 		}
 	}
 
-	this->Scopes.back().AddSymbol(varSymbol);
+	constSymbol.ConstValue = constDecl.DefaultValue->ConstantValue;
+	constDecl.ResolvedSymbol = DeclareSymbol(std::move(constSymbol));
 }
 
-void Overcast::Semantic::Binder::Binder::BindStructDecl(const StructDeclStatement& structDecl)
+void Overcast::Semantic::Binder::Binder::BindStructDecl(StructDeclStatement& structDecl)
 {
 	Symbol structSymbol(structDecl.StructName, SymbolKind::Struct, new IdentifierType(structDecl.StructName));
-	Symbol strCheck("INTERNAL_STRUCT_CHECK", SymbolKind::Variable, &IdentifierType{ "bool" }); // this doesnt matter
-	if (LookupSymbol(structDecl.StructName, strCheck))
+	if (LookupLocalSymbol(structDecl.StructName)) // clashes between files are settled by the global index
 	{
 		throw std::runtime_error("Struct " + structDecl.StructName + " is already defined in this scope.");
 	}
@@ -228,40 +481,52 @@ void Overcast::Semantic::Binder::Binder::BindStructDecl(const StructDeclStatemen
 		memberFunc->Parameters.push_back({ std::move(pointerType), "this" });
 		memberFuncSymbol.ParamCount = memberFunc->Parameters.size();
 		memberFuncSymbol.IsStructMemberFunc = true;
+		memberFuncSymbol.LinkName = MakeFunctionLinkName(memberFunc->FuncName, false, structDecl.StructName);
 		memberFunc->IsStructMember = true;
 		for (const auto& param : memberFunc->Parameters)
 		{
 			memberFuncSymbol.ParamTypeNames.push_back(param.ParameterType->to_string());
+			memberFuncSymbol.ParamTypes.push_back(param.ParameterType.get());
 		}
 
 		structSymbol.StructSymbols.push_back(memberFuncSymbol);
 	}
-	this->Scopes.back().AddSymbol(structSymbol);
+	structSymbol.IndexStructMembers();
+	const Symbol* declaredStruct = DeclareSymbol(std::move(structSymbol));
 	for (const auto& memberFunc : structDecl.MemberFunctions)
 	{
+		memberFunc->ResolvedSymbol = declaredStruct->FindStructMember(memberFunc->FuncName);
 		BindStatement(*memberFunc);
 	}
 }
 
-Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindExpression(Expression& expr)
+const Overcast::Semantic::Binder::Symbol* Overcast::Semantic::Binder::Binder::BindExpression(Expression& expr)
 {
+	const Symbol* result = nullptr;
 	if (dynamic_cast<InvokeFunctionExpr*>(&expr))
 	{
 		InvokeFunctionExpr& funcInv = static_cast<InvokeFunctionExpr&>(expr);
-		return this->BindFuncInvoke(funcInv);
+		result = this->BindFuncInvoke(funcInv);
 	}
 	else if (dynamic_cast<const VariableUseExpr*>(&expr))
 	{
 		VariableUseExpr& varUse = static_cast<VariableUseExpr&>(expr);
-		return this->BindVariableUse(varUse);
+		result = this->BindVariableUse(varUse);
 	}
 	else if (dynamic_cast<const StringLiteralExpr*>(&expr))
 	{
-		return Symbol(std::string("<string_literal>"), SymbolKind::Variable, IdentifierType::GetStringType());
+		static const Symbol stringLiteral(std::string("<string_literal>"), SymbolKind::Variable, IdentifierType::GetStringType());
+		result = &stringLiteral;
 	}
 	else if (dynamic_cast<const IntLiteralExpr*>(&expr))
 	{
-		return Symbol(std::string("<int_literal>"), SymbolKind::Variable, IdentifierType::GetIntType());
+		static const Symbol intLiteral(std::string("<int_literal>"), SymbolKind::Variable, IdentifierType::GetIntType());
+		result = &intLiteral;
+	}
+	else if (dynamic_cast<const BoolLiteralExpr*>(&expr))
+	{
+		static const Symbol boolLiteral(std::string("<bool_literal>"), SymbolKind::Variable, IdentifierType::GetBoolType());
+		result = &boolLiteral;
 	}
 	else if (dynamic_cast<const FloatLiteralExpr*>(&expr))
 	{
@@ -269,55 +534,65 @@ Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindExpre
 	}
 	else if (dynamic_cast<const BinaryExpr*>(&expr))
 	{
-		return this->BindBinaryExpr(static_cast<const BinaryExpr&>(expr));
+		result = this->BindBinaryExpr(static_cast<const BinaryExpr&>(expr));
 	}
 	else if (dynamic_cast<const StructCtorExpr*>(&expr))
 	{
-		return this->BindStructCtor(static_cast<const StructCtorExpr&>(expr));
+		result = this->BindStructCtor(static_cast<StructCtorExpr&>(expr));
 	}
 	else if (dynamic_cast<const StructAccessExpr*>(&expr))
 	{
-		return this->BindStructAccess(static_cast<const StructAccessExpr&>(expr));
+		result = this->BindStructAccess(static_cast<StructAccessExpr&>(expr));
 	}
 	else
 	{
 		throw std::runtime_error("Unsupported expression type for binding.");
 	}
+
+	if (result)
+	{
+		expr.ResolvedSymbol = result;
+		expr.ResolvedType = result->Type;
+
+		const auto typeName = result->Type ? result->Type->to_string() : "";
+		if ((typeName == "int" || typeName == "bool") && !ConstEvaluator::Fold(expr) && ConstEvaluator::DividesByZero(expr))
+			Warnings.push_back("Division by zero" + (CurrentFunction ? " in " + CurrentFunction->Name : std::string()) + ", it's left for run time.");
+	}
+	return result;
 }
 
-Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindFuncInvoke(InvokeFunctionExpr& funcInv)
+const Overcast::Semantic::Binder::Symbol* Overcast::Semantic::Binder::Binder::BindFuncInvoke(InvokeFunctionExpr& funcInv)
 {
-	Symbol funcSymbol;
-	funcSymbol = BindExpression(*funcInv.InvokedFunction);
+	const Symbol* funcSymbol = BindExpression(*funcInv.InvokedFunction);
 
-	if (funcSymbol.Kind != SymbolKind::Function)
+	if (funcSymbol->Kind != SymbolKind::Function)
 	{
-		throw std::runtime_error("Symbol " + funcSymbol.Name + " is not a function, or is undefined.");
+		throw std::runtime_error("Symbol " + funcSymbol->Name + " is not a function, or is undefined.");
 	}
 
-	if (funcSymbol.IsStructMemberFunc)
-		funcInv.IsStructFunc = true;
+	if (!funcSymbol->IsBuiltin)
+		CalledFunctions.insert(funcSymbol->LinkName);
 
-	if (!funcSymbol.Variadic)
+	if (!funcSymbol->Variadic)
 	{
-		auto tsFnArgC = funcSymbol.ParamCount;
-		if (funcSymbol.IsStructMemberFunc)
+		auto tsFnArgC = funcSymbol->ParamCount;
+		if (funcSymbol->IsStructMemberFunc)
 			tsFnArgC--;
 
 		if (funcInv.Arguments.size() != tsFnArgC)
 		{
-			throw std::runtime_error("Function " + funcSymbol.Name + " expects " +
-				std::to_string(funcSymbol.ParamCount) + " arguments, but got " + std::to_string(funcInv.Arguments.size()) + ".");
+			throw std::runtime_error("Function " + funcSymbol->Name + " expects " +
+				std::to_string(funcSymbol->ParamCount) + " arguments, but got " + std::to_string(funcInv.Arguments.size()) + ".");
 		}
 
 		for (int i = 0; i < tsFnArgC; i++)
 		{
-			auto& arg = BindExpression(*funcInv.Arguments[i]);
-			if (arg.Type->to_string() != funcSymbol.ParamTypeNames[i])
+			const Symbol* arg = BindExpression(*funcInv.Arguments[i]);
+			if (arg->Type->to_string() != funcSymbol->ParamTypeNames[i])
 			{
 				throw std::runtime_error("Argument " + std::to_string(i + 1) + " of function " +
-					funcSymbol.Name + " is of type " + arg.Type->to_string() +
-					", but expected type is " + funcSymbol.ParamTypeNames[i] + ".");
+					funcSymbol->Name + " is of type " + arg->Type->to_string() +
+					", but expected type is " + funcSymbol->ParamTypeNames[i] + ".");
 			}
 		}
 	}
@@ -330,31 +605,30 @@ Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindFuncI
 	return funcSymbol;
 }
 
-Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindVariableUse(VariableUseExpr& varUse)
+const Overcast::Semantic::Binder::Symbol* Overcast::Semantic::Binder::Binder::BindVariableUse(VariableUseExpr& varUse)
 {
-	Symbol varSymbol;
-	if (!LookupSymbol(varUse.VariableName, varSymbol))
+	const Symbol* varSymbol = LookupSymbol(varUse.VariableName);
+	if (!varSymbol)
 	{
 		throw std::runtime_error(varUse.VariableName + " is not defined in this scope.");
 	}
 
-	if (varSymbol.Kind != SymbolKind::Variable) // ik I could've slammed that into one if statement, but I prefer this over a long condition lol
+	if (varSymbol->Kind != SymbolKind::Variable) // ik I could've slammed that into one if statement, but I prefer this over a long condition lol
 	{
-		if (varSymbol.Kind != SymbolKind::Function)
+		if (varSymbol->Kind != SymbolKind::Function)
 		{
 			throw std::runtime_error(varUse.VariableName + " is not defined in this scope.");
 		}
 	}
 
-	varUse.isFunc = varSymbol.Kind == SymbolKind::Function;
 	return varSymbol;
 }
 
-Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindBinaryExpr(const BinaryExpr& binExpr)
+const Overcast::Semantic::Binder::Symbol* Overcast::Semantic::Binder::Binder::BindBinaryExpr(const BinaryExpr& binExpr)
 {
-	Symbol leftSymbol = BindExpression(*binExpr.A);
-	Symbol rightSymbol = BindExpression(*binExpr.B);
-	if (leftSymbol.Type->to_string() != rightSymbol.Type->to_string())
+	const Symbol* leftSymbol = BindExpression(*binExpr.A);
+	const Symbol* rightSymbol = BindExpression(*binExpr.B);
+	if (leftSymbol->Type->to_string() != rightSymbol->Type->to_string())
 	{
 		throw std::runtime_error("Binary expression operands must be of the same type.");
 	}
@@ -362,45 +636,38 @@ Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindBinar
 		binExpr.Operator == ">=" || binExpr.Operator == "<=" ||
 		binExpr.Operator == "==" || binExpr.Operator == "!=")
 	{
-		return Symbol("<binary_expr>", SymbolKind::Variable, IdentifierType::GetBoolType());
+		return GetValueSymbol(IdentifierType::GetBoolType());
 	}
-	return Symbol("<binary_expr>", SymbolKind::Variable, leftSymbol.Type);
+	return GetValueSymbol(leftSymbol->Type);
 }
 
-Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindStructCtor(const StructCtorExpr& structCtor)
+const Overcast::Semantic::Binder::Symbol* Overcast::Semantic::Binder::Binder::BindStructCtor(StructCtorExpr& structCtor)
 {
-	Symbol structSymbol;
-	if (!LookupSymbol(structCtor.StructTypeName, structSymbol))
+	const Symbol* structSymbol = LookupSymbol(structCtor.StructTypeName);
+	if (!structSymbol)
 	{
 		throw std::runtime_error("Struct " + structCtor.StructTypeName + " is not defined.");
 	}
 
-	if (structSymbol.Kind != SymbolKind::Struct)
+	if (structSymbol->Kind != SymbolKind::Struct)
 	{
 		throw std::runtime_error("Identifier " + structCtor.StructTypeName + " is not a struct.");
 	}
 
-	Symbol ctorSymbol("<INVALID>", SymbolKind::Variable, structSymbol.Type);
-	for (auto& symbol : structSymbol.StructSymbols)
-	{
-		if (symbol.Kind == SymbolKind::Function && symbol.Name == "ctor") // that means there's a ctor
-		{
-			ctorSymbol = symbol;
-			break;
-		}
-	}
-
-	if (ctorSymbol.Name != "<INVALID>")
+	const Symbol* ctorSymbol = structSymbol->FindStructMember("ctor");
+	if (ctorSymbol && ctorSymbol->Kind == SymbolKind::Function) // that means there's a ctor
 	{
-		if (structCtor.Arguments.size() != ctorSymbol.ParamTypeNames.size()-1)
+		structCtor.ResolvedCtor = ctorSymbol;
+		CalledFunctions.insert(ctorSymbol->LinkName);
+		if (structCtor.Arguments.size() != ctorSymbol->ParamTypeNames.size()-1)
 		{
 			throw std::runtime_error("No overload of struct " + structCtor.StructTypeName + "'s constructors take " + std::to_string(structCtor.Arguments.size()) + " arguments.");
 		}
 
-		for (int i = 0; i < ctorSymbol.ParamTypeNames.size()-1; i++)
+		for (int i = 0; i < ctorSymbol->ParamTypeNames.size()-1; i++)
 		{
-			auto& param = ctorSymbol.ParamTypeNames[i];
-			auto& arg = BindExpression(*structCtor.Arguments[i]).Type->to_string();
+			auto& param = ctorSymbol->ParamTypeNames[i];
+			auto arg = BindExpression(*structCtor.Arguments[i])->Type->to_string();
 
 			if (param != arg)
 			{
@@ -410,7 +677,7 @@ Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindStruc
 	}
 	else
 	{
-		if (structCtor.Arguments.size() != ctorSymbol.ParamTypeNames.size())
+		if (!structCtor.Arguments.empty())
 		{
 			throw std::runtime_error("No overload of struct " + structCtor.StructTypeName + "'s constructors take " + std::to_string(structCtor.Arguments.size()) + " arguments.");
 		}
@@ -419,29 +686,101 @@ Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindStruc
 	return structSymbol;
 }
 
-Overcast::Semantic::Binder::Symbol Overcast::Semantic::Binder::Binder::BindStructAccess(const StructAccessExpr& structAcc)
+const Overcast::Semantic::Binder::Symbol* Overcast::Semantic::Binder::Binder::BindStructAccess(StructAccessExpr& structAcc)
 {
-	Symbol structObject = BindExpression(*structAcc.LHS);
-	Symbol structSymbol;
+	const Symbol* structObject = BindExpression(*structAcc.LHS);
 
-	auto typeName = structObject.Type->getBaseType()->to_string();
+	auto typeName = structObject->Type->getBaseType()->to_string();
 
-	if (!LookupSymbol(typeName, structSymbol))
+	const Symbol* structSymbol = LookupSymbol(typeName);
+	if (!structSymbol)
 	{
 		throw std::runtime_error("Struct " + typeName + " was not defined in this program.");
 	}
-	if (structSymbol.Kind != SymbolKind::Struct)
+	if (structSymbol->Kind != SymbolKind::Struct)
+	{
+		throw std::runtime_error(structObject->Name + " is not a struct-type symbol.");
+	}
+
+	const Symbol* member = structSymbol->FindStructMember(structAcc.MemberName);
+	if (!member) {
+		throw std::runtime_error(structAcc.MemberName + " is not a valid member of struct " + structSymbol->Name + ".");
+	}
+
+	structAcc.ResolvedStruct = structSymbol;
+	return member;
+}
+
+const Overcast::Semantic::Binder::Symbol* Overcast::Semantic::Binder::Binder::GetValueSymbol(OCType* type)
+{
+	auto it = ValueSymbols.find(type);
+	if (it != ValueSymbols.end())
+		return &Symbols.Get(it->second);
+
+	auto handle = Symbols.Add(Symbol("<value>", SymbolKind::Variable, type));
+	ValueSymbols.insert({ type, handle });
+	return &Symbols.Get(handle);
+}
+void Overcast::Semantic::Binder::Binder::BindFunctionBodies()
+{
+	if (PendingBodies.empty())
+		return;
+
+	// bodies only read the file scope and the globals, so each chunk gets its own binder and they all run at once
+	size_t workers = std::min<size_t>(WorkerCount, (PendingBodies.size() + MinBodiesPerWorker - 1) / MinBodiesPerWorker);
+	workers = std::max<size_t>(workers, 1);
+	size_t chunkSize = (PendingBodies.size() + workers - 1) / workers;
+
+	auto bindChunk = [this, chunkSize](Binder* bodyBinder, size_t chunk) {
+		size_t end = std::min(PendingBodies.size(), (chunk + 1) * chunkSize);
+		for (size_t i = chunk * chunkSize; i < end; i++)
+		{
+			bodyBinder->BindFunctionBody(*PendingBodies[i]);
+		}
+	};
+
+	for (size_t chunk = 0; chunk < workers; chunk++)
+	{
+		BodyBinders.push_back(std::unique_ptr<Binder>(new Binder(this)));
+	}
+
+	std::vector<std::future<void>> futures;
+	for (size_t chunk = 1; chunk < workers; chunk++)
+	{
+		futures.push_back(std::async(std::launch::async, bindChunk, BodyBinders[chunk].get(), chunk));
+	}
+
+	// wait on every chunk before throwing, and throw the first error in file order so it matches a serial bind
+	std::exception_ptr firstError;
+	try
+	{
+		bindChunk(BodyBinders[0].get(), 0);
+	}
+	catch (...)
 	{
-		throw std::runtime_error(structObject.Name + " is not a struct-type symbol.");
+		firstError = std::current_exception();
 	}
 
-	auto& members = structSymbol.StructSymbols;
-	auto it = std::find_if(members.begin(), members.end(), [&](const Symbol& sym) {
-		return sym.Name == structAcc.MemberName;
-		});
-	if (it == members.end()) {
-		throw std::runtime_error(structAcc.MemberName + " is not a valid member of struct " + structSymbol.Name + ".");
+	for (auto& future : futures)
+	{
+		try
+		{
+			future.get();
+		}
+		catch (...)
+		{
+			if (!firstError)
+				firstError = std::current_exception();
+		}
 	}
 
-	return *it;
+	PendingBodies.clear();
+	if (firstError)
+		std::rethrow_exception(firstError);
+
+	for (const auto& bodyBinder : BodyBinders)
+	{
+		CalledFunctions.insert(bodyBinder->CalledFunctions.begin(), bodyBinder->CalledFunctions.end());
+		Warnings.insert(Warnings.end(), bodyBinder->Warnings.begin(), bodyBinder->Warnings.end());
+	}
 }
@@ -1,129 +1,190 @@
 #pragma once
 #include <iostream>
 #include <unordered_map>
+#include <unordered_set>
 #include <stack>
 #include <string>
 #include "Overcast/SyntaxAnalysis/statements.h"
 #include "Overcast/SyntaxAnalysis/expressions.h"
+#include "symbol_table.h"
 
 namespace Overcast::Semantic::Binder
 {
-	enum class SymbolKind
-	{
-		Variable,
-		Struct,
-		Function
-	};
-
-	struct Symbol
-	{
-		std::string Name;
-		SymbolKind Kind;
-
-		OCType* Type; 
-
-		int ParamCount = 0; // for functions
-		std::vector<std::string> ParamTypeNames; // for functions, names of parameters
-		std::vector<OCType*> ParamTypes;
-		std::vector<Symbol> StructSymbols; // for structs, members of the struct
-		bool Variadic = false;
-		bool IsStructMemberFunc = false;
-
-		Symbol() : Name(""), Kind(SymbolKind::Variable), Type(nullptr) {}
-		Symbol(const std::string& name, SymbolKind kind, OCType* type)
-			: Name(name), Kind(kind), Type(type)
-		{
-		}
-	};
-
-	struct Scope
-	{
-		std::unordered_map<std::string, Symbol> Symbols;
-		void AddSymbol(const Symbol& symbol)
-		{
-			Symbols.insert({ symbol.Name, symbol });
-		}
-
-		bool TryGetSymbol(const std::string& name, Symbol& outSymbol) const
-		{
-			auto it = Symbols.find(name);
-			if (it != Symbols.end())
-			{
-				outSymbol = it->second;
-				return true;
-			}
-			return false;
-		}
-	};
-
 	class Binder
 	{
 	public:
 		void Run(const std::vector<std::unique_ptr<Statement>>& statements)
 		{
-			Symbol printFunc("print", SymbolKind::Function, new IdentifierType("int"));
-			printFunc.Variadic = true;
-
-			this->Scopes.back().AddSymbol(printFunc);
-
+			// global pass, function bodies are only queued up here
+			IndexCompileTimeDecls(statements);
 			for (const auto& statement : statements)
 			{
-				BindStatement(*statement);
+				if (BoundStatements.insert(statement.get()).second) // a const further up may have needed it already
+					BindStatement(*statement);
 			}
+
+			BindFunctionBodies();
 			ExitScope();
 		}
 
+		// link names of every function this file calls, the build system works out what has to stay external from these
+		const std::unordered_set<std::string>& GetCalledFunctions() const
+		{
+			return CalledFunctions;
+		}
+
+		// things that are allowed but probably aren't what was meant, in the order a serial bind would find them
+		const std::vector<std::string>& GetWarnings() const
+		{
+			return Warnings;
+		}
+
 		Binder()
 		{
 			EnterScope();
 		}
-		Binder(std::unordered_map<std::string, Symbol> globalSymbols)
+		Binder(std::shared_ptr<const GlobalSymbolIndex> globalSymbols, uint32_t workerCount = 1)
+			: Globals(std::move(globalSymbols)), WorkerCount(workerCount)
 		{
 			EnterScope();
-			for (const auto& s : globalSymbols)
-			{
-				this->Scopes.back().AddSymbol(s.second);
-			}
 		}
 	private:
-		std::vector<Scope> Scopes;
-		Symbol CurrentFunction;
-
-		void BindStatement(const Statement& stmt);
-		void BindFunctionDecl(const FunctionDeclStatement& funcDecl);
-		void BindVariableDecl(const VariableDeclStatement& varDecl);
-		void BindStructDecl(const StructDeclStatement& structDecl);
+		// a function body binder, it only reads the file binder's scope and owns everything it declares
+		// the ones made during the global pass get the file binder as owner, so their consts can have it bind bodies early
+		Binder(const Binder* fileBinder, Binder* owner = nullptr)
+			: Globals(fileBinder->Globals), FileBinder(fileBinder), Owner(owner)
+		{
+			EnterScope();
+		}
 
-		Symbol BindExpression(Expression& expr);
-		Symbol BindFuncInvoke(InvokeFunctionExpr& funcInv);
-		Symbol BindVariableUse(VariableUseExpr& varUse);
-		Symbol BindBinaryExpr(const BinaryExpr& binExpr);
-		Symbol BindStructCtor(const StructCtorExpr& structCtor);
-		Symbol BindStructAccess(const StructAccessExpr& structAcc);
+		static constexpr size_t MinBodiesPerWorker = 8; // fewer than this per thread and it's not worth spawning one
+
+		std::shared_ptr<const GlobalSymbolIndex> Globals; // looked at after every local scope
+		const Binder* FileBinder = nullptr; // set on function body binders, frozen while they run
+		Binder* Owner = nullptr; // set on compile-time body binders, the global pass is single threaded so they can change it
+		uint32_t WorkerCount = 1;
+		SymbolArena Symbols;
+		ScopedSymbolTable Scopes;
+		const Symbol* CurrentFunction = nullptr;
+		std::unordered_set<std::string> CalledFunctions; // body binders keep their own, the file binder merges them
+		std::vector<std::string> Warnings; // same as CalledFunctions
+
+		std::vector<FunctionDeclStatement*> PendingBodies;
+		// bodies the interpreter may run by link name, const funcs and struct member functions are bound up front for it
+		std::unordered_map<std::string, const FunctionDeclStatement*> CompileTimeBodies;
+		// the top-level statements declaring them, so one declared further down can be bound as soon as a const calls it
+		std::unordered_map<std::string, Statement*> CompileTimeDecls;
+		std::unordered_set<const Statement*> BoundStatements;
+		std::vector<std::unique_ptr<Binder>> BodyBinders; // kept alive, the AST points into their symbols
+		std::vector<std::unique_ptr<Binder>> CompileTimeBinders; // one per compile-time body, so the file scope stays as it is
+		void BindFunctionBodies();
+		void IndexCompileTimeDecls(const std::vector<std::unique_ptr<Statement>>& statements);
+		const FunctionDeclStatement* RequireCompileTimeBody(const Symbol* funcSymbol); // binds it first if it's only declared further down
+
+		void BindStatement(Statement& stmt);
+		void CheckAttributes(const Statement& stmt);
+		void BindFunctionDecl(FunctionDeclStatement& funcDecl);
+		void BindFunctionBody(FunctionDeclStatement& funcDecl);
+		void BindVariableDecl(VariableDeclStatement& varDecl);
+		void BindConstDecl(ConstDeclStatement& constDecl);
+		void BindStructDecl(StructDeclStatement& structDecl);
+		const Symbol* BindAssignmentTarget(Expression& target); // rejects consts and their fields
+
+		const Symbol* BindExpression(Expression& expr);
+		const Symbol* BindFuncInvoke(InvokeFunctionExpr& funcInv);
+		const Symbol* BindVariableUse(VariableUseExpr& varUse);
+		const Symbol* BindBinaryExpr(const BinaryExpr& binExpr);
+		const Symbol* BindStructCtor(StructCtorExpr& structCtor);
+		const Symbol* BindStructAccess(StructAccessExpr& structAcc);
+
+		// expression results that aren't named symbols, one per type so they're only made once
+		std::unordered_map<OCType*, SymbolHandle> ValueSymbols;
+		const Symbol* GetValueSymbol(OCType* type);
+
+		const Symbol* DeclareSymbol(Symbol&& symbol)
+		{
+			// first declaration in a scope wins, checked before adding so a duplicate doesn't leave an orphan in the arena
+			if (Scopes.IsBoundInCurrentScope(symbol.Name))
+				return &Symbols.Get(Scopes.Lookup(symbol.Name));
+
+			symbol.Type = GetCanonicalType(symbol.Type);
+			auto handle = Symbols.Add(std::move(symbol));
+			const Symbol& stored = Symbols.Get(handle);
+			Scopes.Bind(stored.Name, handle);
+			return &stored;
+		}
 
 		void EnterScope()
 		{
-			Scopes.push_back(Scope{});
+			Scopes.EnterScope();
 		}
 
 		void ExitScope()
 		{
-			if (Scopes.empty())
+			if (!Scopes.ExitScope())
 			{
 				std::cerr << "Error: Attempted to exit scope when no scopes are active." << std::endl;
-				return;
 			}
-			Scopes.pop_back();
 		}
 
-		bool LookupSymbol(const std::string& name, Symbol& outSymbol) const
+		const Symbol* LookupLocalSymbol(const std::string& name) const
 		{
-			for (auto it = Scopes.rbegin(); it != Scopes.rend(); ++it)
+			auto handle = Scopes.Lookup(name);
+			if (handle == InvalidSymbolHandle)
+				return nullptr;
+			return &Symbols.Get(handle);
+		}
+
+		const FunctionDeclStatement* FindCompileTimeBody(const Symbol* funcSymbol) const
+		{
+			auto it = CompileTimeBodies.find(funcSymbol->LinkName);
+			if (it != CompileTimeBodies.end())
+				return it->second;
+			return FileBinder ? FileBinder->FindCompileTimeBody(funcSymbol) : nullptr;
+		}
+
+		const Symbol* LookupSymbol(const std::string& name) const
+		{
+			if (auto symbol = LookupLocalSymbol(name))
+				return symbol;
+			if (FileBinder)
+			{
+				if (auto symbol = FileBinder->LookupLocalSymbol(name))
+					return symbol;
+			}
+			if (Globals)
+			{
+				if (auto symbol = Globals->Find(name))
+					return symbol;
+			}
+			return FindBuiltin(name);
+		}
+
+		// builtins come last, so a user function with the same name shadows them instead of being bound to them
+		static const Symbol* FindBuiltin(const std::string& name)
+		{
+			static const std::vector<Symbol> builtins = [] {
+				std::vector<Symbol> symbols;
+
+				Symbol printFunc("print", SymbolKind::Function, IdentifierType::GetIntType());
+				printFunc.Variadic = true;
+				printFunc.IsBuiltin = true;
+				symbols.push_back(std::move(printFunc));
+
+				// print is buffered per thread, this sends out what the calling thread has written so far
+				Symbol flushFunc("flush", SymbolKind::Function, IdentifierType::GetVoidType());
+				flushFunc.IsBuiltin = true;
+				symbols.push_back(std::move(flushFunc));
+
+				return symbols;
+			}();
+
+			for (const auto& builtin : builtins)
 			{
-				if (it->TryGetSymbol(name, outSymbol))
-					return true;
+				if (builtin.Name == name)
+					return &builtin;
 			}
-			return false;
+			return nullptr;
 		}
 	};
 }
\ No newline at end of file
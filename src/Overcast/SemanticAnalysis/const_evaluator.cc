@@ -0,0 +1,78 @@
+#include "ocpch.h"
+#include "const_evaluator.h"
+#include "symbol_table.h"
+
+bool Overcast::Semantic::ConstEvaluator::Fold(Expression& expr)
+{
+	if (expr.IsConstant)
+		return true;
+
+	std::optional<int64_t> value;
+	if (auto intExpr = dynamic_cast<const IntLiteralExpr*>(&expr))
+	{
+		value = intExpr->LiteralValue;
+	}
+	else if (auto boolExpr = dynamic_cast<const BoolLiteralExpr*>(&expr))
+	{
+		value = boolExpr->LiteralValue ? 1 : 0;
+	}
+	else if (dynamic_cast<const VariableUseExpr*>(&expr))
+	{
+		// uses of a const are just its value
+		if (expr.ResolvedSymbol && expr.ResolvedSymbol->IsConst)
+			value = expr.ResolvedSymbol->ConstValue;
+	}
+	else if (auto binExpr = dynamic_cast<const BinaryExpr*>(&expr))
+	{
+		if (binExpr->A->IsConstant && binExpr->B->IsConstant && !DividesByZero(expr))
+			value = EvaluateBinary(binExpr->Operator, binExpr->A->ConstantValue, binExpr->B->ConstantValue);
+	}
+
+	if (!value)
+		return false;
+
+	expr.IsConstant = true;
+	expr.ConstantValue = *value;
+	return true;
+}
+
+bool Overcast::Semantic::ConstEvaluator::DividesByZero(const Expression& expr)
+{
+	auto binExpr = dynamic_cast<const BinaryExpr*>(&expr);
+	return binExpr && (binExpr->Operator == "/" || binExpr->Operator == "%") && binExpr->B->IsConstant && binExpr->B->ConstantValue == 0;
+}
+
+std::optional<int64_t> Overcast::Semantic::ConstEvaluator::EvaluateBinary(const std::string& op, int64_t lhs, int64_t rhs)
+{
+	// operands are i32s (or 0/1 for bools) so none of these can overflow an int64 before wrapping
+	if (op == "+")
+		return WrapInt(lhs + rhs);
+	else if (op == "-")
+		return WrapInt(lhs - rhs);
+	else if (op == "*")
+		return WrapInt(lhs * rhs);
+	else if (op == "/" || op == "%")
+	{
+		if (rhs == 0)
+			throw std::runtime_error("Division by zero in constant expression.");
+		return WrapInt(op == "/" ? lhs / rhs : lhs % rhs);
+	}
+	else if (op == "==")
+		return lhs == rhs;
+	else if (op == "!=")
+		return lhs != rhs;
+	else if (op == "<")
+		return lhs < rhs;
+	else if (op == "<=")
+		return lhs <= rhs;
+	else if (op == ">")
+		return lhs > rhs;
+	else if (op == ">=")
+		return lhs >= rhs;
+	else if (op == "&&")
+		return lhs && rhs;
+	else if (op == "||")
+		return lhs || rhs;
+
+	return std::nullopt;
+}
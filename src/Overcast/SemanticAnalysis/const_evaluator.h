@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Overcast/SyntaxAnalysis/expressions.h"
+
+namespace Overcast::Semantic
+{
+	// a value known at compile time, ints and bools live in Int, struct objects in Fields
+	// (shared, so a pointer to an object and the object itself see the same fields)
+	struct ConstValue
+	{
+		OCType* Type = nullptr;
+		int64_t Int = 0;
+		std::shared_ptr<std::vector<ConstValue>> Fields; // null for non-structs and null pointers
+
+		// copies what a by-value struct copy would, pointers still point at the same object
+		ConstValue Clone() const
+		{
+			ConstValue copy = *this;
+			if (Fields && !dynamic_cast<PointerType*>(Type))
+			{
+				copy.Fields = std::make_shared<std::vector<ConstValue>>();
+				for (const auto& field : *Fields)
+					copy.Fields->push_back(field.Clone());
+			}
+			return copy;
+		}
+	};
+
+	// folds int and bool expressions at compile time, ints wrap around like the i32s codegen would make
+	class ConstEvaluator
+	{
+	public:
+		// call on an expression that was just bound, its operands have to be folded already (the binder goes bottom-up)
+		// marks it IsConstant and returns true if it folded
+		static bool Fold(Expression& expr);
+		// x / 0 and x % 0 aren't folded, the code might never run, so the binder only warns about them
+		static bool DividesByZero(const Expression& expr);
+
+		static std::optional<int64_t> EvaluateBinary(const std::string& op, int64_t lhs, int64_t rhs);
+	private:
+		static int64_t WrapInt(int64_t value)
+		{
+			return static_cast<int32_t>(static_cast<uint32_t>(value));
+		}
+	};
+}
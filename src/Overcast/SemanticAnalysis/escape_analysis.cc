@@ -0,0 +1,190 @@
+#include "ocpch.h"
+#include "escape_analysis.h"
+
+void Overcast::Semantic::EscapeAnalysis::Run(FunctionDeclStatement& funcDecl, const AttributeInference::StructLookup& findStruct)
+{
+	EscapeAnalysis analysis;
+	analysis.FindStruct = findStruct;
+	analysis.VisitBlock(funcDecl.Body);
+
+	for (const auto& [var, objects] : analysis.VarObjects)
+	{
+		if (analysis.EscapingVars.count(var))
+		{
+			for (auto* object : objects)
+				object->Escapes = true;
+		}
+	}
+}
+
+void Overcast::Semantic::EscapeAnalysis::VisitBlock(const std::vector<std::unique_ptr<Statement>>& block)
+{
+	for (const auto& stmt : block)
+	{
+		VisitStatement(*stmt);
+	}
+}
+
+void Overcast::Semantic::EscapeAnalysis::VisitStatement(Statement& stmt)
+{
+	switch (stmt.m_Type)
+	{
+	case Statement::Type::VariableDecl:
+	{
+		auto& varDecl = static_cast<VariableDeclStatement&>(stmt);
+		if (!varDecl.Defined || !varDecl.DefaultValue)
+			break;
+
+		if (auto ctorExpr = dynamic_cast<StructCtorExpr*>(varDecl.DefaultValue.get()))
+		{
+			// the object is the var, so it escapes when the var does
+			VisitCtor(*ctorExpr, false);
+			VarObjects[varDecl.ResolvedSymbol].push_back(ctorExpr);
+		}
+		else
+		{
+			VisitExpression(*varDecl.DefaultValue, true);
+		}
+		break;
+	}
+	case Statement::Type::Assignment:
+	{
+		auto& assign = static_cast<AssignmentStatement&>(stmt);
+		VisitExpression(*assign.LHS, false);
+		if (auto ctorExpr = dynamic_cast<StructCtorExpr*>(assign.Value.get()))
+			VisitCtor(*ctorExpr, false); // constructed in place, there's no new storage
+		else
+			VisitExpression(*assign.Value, true);
+		break;
+	}
+	case Statement::Type::CompoundAssignment:
+	{
+		auto& assign = static_cast<CompoundAssignmentStatement&>(stmt);
+		VisitExpression(*assign.LHS, false);
+		VisitExpression(*assign.Value, false); // only ints
+		break;
+	}
+	case Statement::Type::Expression:
+		VisitExpression(*static_cast<ExpressionStatement&>(stmt).EncapsulatedExpr, false);
+		break;
+	case Statement::Type::Return:
+	{
+		auto& retStmt = static_cast<ReturnStatement&>(stmt);
+		if (retStmt.ReturnValue)
+			VisitExpression(*retStmt.ReturnValue, true);
+		break;
+	}
+	case Statement::Type::If:
+	{
+		auto& ifStmt = static_cast<IfStatement&>(stmt);
+		VisitExpression(*ifStmt.Condition, false);
+		VisitBlock(ifStmt.Body);
+		VisitBlock(ifStmt.ElseBody);
+		break;
+	}
+	case Statement::Type::While:
+	{
+		auto& whStmt = static_cast<WhileStatement&>(stmt);
+		VisitExpression(*whStmt.Condition, false);
+		VisitBlock(whStmt.Body);
+		break;
+	}
+	case Statement::Type::For:
+	{
+		auto& forStmt = static_cast<ForStatement&>(stmt);
+		if (forStmt.Init)
+			VisitStatement(*forStmt.Init);
+		if (forStmt.Condition)
+			VisitExpression(*forStmt.Condition, false);
+		if (forStmt.Step)
+			VisitStatement(*forStmt.Step);
+		VisitBlock(forStmt.Body);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void Overcast::Semantic::EscapeAnalysis::VisitExpression(Expression& expr, bool escapes)
+{
+	if (auto ctorExpr = dynamic_cast<StructCtorExpr*>(&expr))
+	{
+		VisitCtor(*ctorExpr, escapes);
+	}
+	else if (auto varExpr = dynamic_cast<VariableUseExpr*>(&expr))
+	{
+		if (escapes && varExpr->ResolvedSymbol)
+			EscapingVars.insert(varExpr->ResolvedSymbol);
+	}
+	else if (auto binExpr = dynamic_cast<BinaryExpr*>(&expr))
+	{
+		VisitExpression(*binExpr->A, false);
+		VisitExpression(*binExpr->B, false);
+	}
+	else if (auto strAccExpr = dynamic_cast<StructAccessExpr*>(&expr))
+	{
+		VisitExpression(*strAccExpr->LHS, false); // reading a field doesn't hand the object out
+	}
+	else if (auto funcCall = dynamic_cast<InvokeFunctionExpr*>(&expr))
+	{
+		// the callee could keep anything it's given
+		for (auto& arg : funcCall->Arguments)
+		{
+			VisitExpression(*arg, true);
+		}
+
+		if (auto method = dynamic_cast<StructAccessExpr*>(funcCall->InvokedFunction.get()))
+		{
+			bool leaksThis = !method->ResolvedStruct || !method->ResolvedSymbol || MayLeakThis(*method->ResolvedStruct, *method->ResolvedSymbol);
+			VisitExpression(*method->LHS, leaksThis);
+		}
+		else
+		{
+			VisitExpression(*funcCall->InvokedFunction, false);
+		}
+	}
+}
+
+void Overcast::Semantic::EscapeAnalysis::VisitCtor(StructCtorExpr& ctorExpr, bool escapes)
+{
+	ctorExpr.Escapes = escapes;
+
+	for (auto& arg : ctorExpr.Arguments)
+	{
+		VisitExpression(*arg, true);
+	}
+
+	// same as a method, the ctor gets 'this'
+	if (ctorExpr.ResolvedSymbol && ctorExpr.ResolvedCtor && MayLeakThis(*ctorExpr.ResolvedSymbol, *ctorExpr.ResolvedCtor))
+		ctorExpr.Escapes = true;
+}
+
+bool Overcast::Semantic::EscapeAnalysis::MayLeakThis(const Binder::Symbol& structSymbol, const Binder::Symbol& method) const
+{
+	// 'this' is the only pointer in the language, so it can only get out through something that can hold a pointer:
+	// the return value, a parameter (structs are passed around as references), or a field of the object itself
+	if (!method.Type || MayHoldThis(*method.Type))
+		return true;
+
+	for (size_t i = 0; i + 1 < method.ParamTypes.size(); i++) // the last one is 'this'
+	{
+		if (MayHoldThis(*method.ParamTypes[i]))
+			return true;
+	}
+
+	for (const auto& member : structSymbol.StructSymbols)
+	{
+		if (member.Kind == Binder::SymbolKind::Variable && MayHoldThis(*member.Type))
+			return true;
+	}
+
+	return false;
+}
+
+bool Overcast::Semantic::EscapeAnalysis::MayHoldThis(const OCType& type) const
+{
+	if (type.to_string() == "void")
+		return false;
+	return !AttributeInference::HoldsNoPointers(type, FindStruct);
+}
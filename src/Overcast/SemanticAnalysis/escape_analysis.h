@@ -0,0 +1,32 @@
+#pragma once
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Overcast/SyntaxAnalysis/statements.h"
+#include "Overcast/SyntaxAnalysis/expressions.h"
+#include "symbol_table.h"
+#include "attribute_inference.h"
+
+namespace Overcast::Semantic
+{
+	// finds the `new` objects that can't outlive their function's frame and clears StructCtorExpr::Escapes on them,
+	// it only looks at one bound function body at a time, so calls are treated conservatively
+	class EscapeAnalysis
+	{
+	public:
+		static void Run(FunctionDeclStatement& funcDecl, const AttributeInference::StructLookup& findStruct);
+	private:
+		AttributeInference::StructLookup FindStruct;
+		std::unordered_map<const Binder::Symbol*, std::vector<StructCtorExpr*>> VarObjects; // the objects each var was initialized with
+		std::unordered_set<const Binder::Symbol*> EscapingVars;
+
+		void VisitBlock(const std::vector<std::unique_ptr<Statement>>& block);
+		void VisitStatement(Statement& stmt);
+		void VisitExpression(Expression& expr, bool escapes);
+		void VisitCtor(StructCtorExpr& ctorExpr, bool escapes);
+
+		// whether calling the method could hand its 'this' to something that outlives the call
+		bool MayLeakThis(const Binder::Symbol& structSymbol, const Binder::Symbol& method) const;
+		bool MayHoldThis(const OCType& type) const;
+	};
+}
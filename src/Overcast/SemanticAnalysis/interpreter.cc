@@ -0,0 +1,318 @@
+#include "ocpch.h"
+#include "interpreter.h"
+
+Overcast::Semantic::ConstValue Overcast::Semantic::Interpreter::Evaluate(const Expression& expr)
+{
+	Frame frame; // nothing's local at the top, const initializers can only see consts and functions
+	return Eval(expr, frame);
+}
+
+Overcast::Semantic::ConstValue Overcast::Semantic::Interpreter::Call(const Binder::Symbol& funcSymbol, std::vector<ConstValue>&& args)
+{
+	const FunctionDeclStatement* body = FindBody(&funcSymbol);
+	if (!body)
+	{
+		throw std::runtime_error("Function " + funcSymbol.Name + " can't be called at compile time, only const funcs and struct member functions can.");
+	}
+
+	if (++Depth > MaxCallDepth)
+	{
+		throw std::runtime_error("Compile-time evaluation went over " + std::to_string(MaxCallDepth) + " nested calls in " + funcSymbol.Name + ".");
+	}
+
+	Frame frame;
+	for (size_t i = 0; i < body->Parameters.size() && i < args.size(); i++)
+	{
+		frame[body->Parameters[i].ResolvedSymbol] = std::move(args[i]);
+	}
+
+	ConstValue result;
+	result.Type = funcSymbol.Type;
+	Execute(body->Body, frame, result);
+
+	Depth--;
+	return result;
+}
+
+Overcast::Semantic::Interpreter::Flow Overcast::Semantic::Interpreter::Execute(const std::vector<std::unique_ptr<Statement>>& block, Frame& frame, ConstValue& result)
+{
+	for (const auto& stmt : block)
+	{
+		if (Execute(*stmt, frame, result) == Flow::Return)
+			return Flow::Return;
+	}
+	return Flow::Normal;
+}
+
+Overcast::Semantic::Interpreter::Flow Overcast::Semantic::Interpreter::Execute(const Statement& stmt, Frame& frame, ConstValue& result)
+{
+	Tick();
+	switch (stmt.m_Type)
+	{
+	case Statement::Type::VariableDecl:
+	{
+		const auto& varDecl = static_cast<const VariableDeclStatement&>(stmt);
+		OCType* type = varDecl.ResolvedSymbol->Type;
+		frame[varDecl.ResolvedSymbol] = varDecl.Defined ? PassAs(Eval(*varDecl.DefaultValue, frame), type) : MakeDefault(type);
+		return Flow::Normal;
+	}
+	case Statement::Type::ConstDecl:
+		return Flow::Normal; // already folded by the binder
+	case Statement::Type::Assignment:
+	{
+		const auto& assign = static_cast<const AssignmentStatement&>(stmt);
+		Assign(*assign.LHS, Eval(*assign.Value, frame), frame);
+		return Flow::Normal;
+	}
+	case Statement::Type::CompoundAssignment:
+	{
+		const auto& assign = static_cast<const CompoundAssignmentStatement&>(stmt);
+		CompoundAssign(assign, frame);
+		return Flow::Normal;
+	}
+	case Statement::Type::Expression:
+	{
+		Eval(*static_cast<const ExpressionStatement&>(stmt).EncapsulatedExpr, frame);
+		return Flow::Normal;
+	}
+	case Statement::Type::If:
+	{
+		const auto& ifStmt = static_cast<const IfStatement&>(stmt);
+		if (Eval(*ifStmt.Condition, frame).Int)
+			return Execute(ifStmt.Body, frame, result);
+		return Execute(ifStmt.ElseBody, frame, result);
+	}
+	case Statement::Type::While:
+	{
+		const auto& whStmt = static_cast<const WhileStatement&>(stmt);
+		while (Eval(*whStmt.Condition, frame).Int)
+		{
+			if (Execute(whStmt.Body, frame, result) == Flow::Return)
+				return Flow::Return;
+		}
+		return Flow::Normal;
+	}
+	case Statement::Type::For:
+	{
+		const auto& forStmt = static_cast<const ForStatement&>(stmt);
+		if (forStmt.Init)
+			Execute(*forStmt.Init, frame, result);
+		while (!forStmt.Condition || Eval(*forStmt.Condition, frame).Int)
+		{
+			if (Execute(forStmt.Body, frame, result) == Flow::Return)
+				return Flow::Return;
+			if (forStmt.Step)
+				Execute(*forStmt.Step, frame, result);
+		}
+		return Flow::Normal;
+	}
+	case Statement::Type::Return:
+	{
+		const auto& retStmt = static_cast<const ReturnStatement&>(stmt);
+		if (retStmt.ReturnValue)
+			result = PassAs(Eval(*retStmt.ReturnValue, frame), result.Type);
+		return Flow::Return;
+	}
+	default:
+		throw std::runtime_error("This statement can't be run at compile time.");
+	}
+}
+
+Overcast::Semantic::ConstValue Overcast::Semantic::Interpreter::Eval(const Expression& expr, Frame& frame)
+{
+	Tick();
+	if (expr.IsConstant)
+	{
+		return { expr.ResolvedType, expr.ConstantValue };
+	}
+
+	if (auto varExpr = dynamic_cast<const VariableUseExpr*>(&expr))
+	{
+		const auto* symbol = varExpr->ResolvedSymbol;
+		if (symbol->ConstObject)
+			return symbol->ConstObject->Clone(); // never hand out the const itself, it could be written through
+
+		auto it = frame.find(symbol);
+		if (it == frame.end())
+		{
+			throw std::runtime_error(varExpr->VariableName + " can't be read at compile time.");
+		}
+		return it->second;
+	}
+	else if (auto binExpr = dynamic_cast<const BinaryExpr*>(&expr))
+	{
+		auto lhs = Eval(*binExpr->A, frame);
+		auto rhs = Eval(*binExpr->B, frame);
+		if (lhs.Fields || rhs.Fields)
+		{
+			throw std::runtime_error("Operator " + binExpr->Operator + " can't be used on structs at compile time.");
+		}
+
+		auto value = ConstEvaluator::EvaluateBinary(binExpr->Operator, lhs.Int, rhs.Int);
+		if (!value)
+		{
+			throw std::runtime_error("Operator " + binExpr->Operator + " can't be evaluated at compile time.");
+		}
+		return { expr.ResolvedType, *value };
+	}
+	else if (auto funcCall = dynamic_cast<const InvokeFunctionExpr*>(&expr))
+	{
+		const auto* funcSymbol = funcCall->ResolvedSymbol;
+
+		std::vector<ConstValue> args;
+		for (size_t i = 0; i < funcCall->Arguments.size(); i++)
+		{
+			auto arg = Eval(*funcCall->Arguments[i], frame);
+			args.push_back(i < funcSymbol->ParamTypes.size() ? PassAs(arg, funcSymbol->ParamTypes[i]) : arg);
+		}
+
+		if (funcSymbol->IsStructMemberFunc) // 'this' goes last, like codegen passes it
+		{
+			auto strAccExpr = dynamic_cast<const StructAccessExpr*>(funcCall->InvokedFunction.get());
+			if (!strAccExpr)
+			{
+				throw std::runtime_error("Member function " + funcSymbol->Name + " called without an object.");
+			}
+			args.push_back(PassAs(Eval(*strAccExpr->LHS, frame), funcSymbol->ParamTypes.back()));
+		}
+
+		return Call(*funcSymbol, std::move(args));
+	}
+	else if (auto strCtorExpr = dynamic_cast<const StructCtorExpr*>(&expr))
+	{
+		auto object = MakeDefault(expr.ResolvedType);
+		if (strCtorExpr->ResolvedCtor)
+		{
+			const auto& ctor = *strCtorExpr->ResolvedCtor;
+
+			std::vector<ConstValue> args;
+			for (size_t i = 0; i < strCtorExpr->Arguments.size(); i++)
+			{
+				args.push_back(PassAs(Eval(*strCtorExpr->Arguments[i], frame), ctor.ParamTypes[i]));
+			}
+			args.push_back(PassAs(object, ctor.ParamTypes.back()));
+			Call(ctor, std::move(args));
+		}
+		return object;
+	}
+	else if (auto strAccExpr = dynamic_cast<const StructAccessExpr*>(&expr))
+	{
+		return GetField(Eval(*strAccExpr->LHS, frame), *strAccExpr->ResolvedSymbol);
+	}
+
+	throw std::runtime_error("This expression can't be evaluated at compile time.");
+}
+
+void Overcast::Semantic::Interpreter::Assign(const Expression& target, const ConstValue& value, Frame& frame)
+{
+	if (auto varExpr = dynamic_cast<const VariableUseExpr*>(&target))
+	{
+		auto it = frame.find(varExpr->ResolvedSymbol);
+		if (it == frame.end())
+		{
+			throw std::runtime_error(varExpr->VariableName + " can't be assigned at compile time.");
+		}
+		it->second = PassAs(value, varExpr->ResolvedSymbol->Type);
+	}
+	else if (auto strAccExpr = dynamic_cast<const StructAccessExpr*>(&target))
+	{
+		// the object shares its fields with wherever it came from, so writing through the copy is fine
+		auto object = Eval(*strAccExpr->LHS, frame);
+		GetField(object, *strAccExpr->ResolvedSymbol) = PassAs(value, strAccExpr->ResolvedSymbol->Type);
+	}
+	else
+	{
+		throw std::runtime_error("This can't be assigned to at compile time.");
+	}
+}
+
+void Overcast::Semantic::Interpreter::CompoundAssign(const CompoundAssignmentStatement& assign, Frame& frame)
+{
+	// the target is looked up once, same as codegen does it
+	ConstValue object; // keeps the fields alive while target points into them
+	ConstValue* target = nullptr;
+	if (auto varExpr = dynamic_cast<const VariableUseExpr*>(assign.LHS.get()))
+	{
+		auto it = frame.find(varExpr->ResolvedSymbol);
+		if (it == frame.end())
+		{
+			throw std::runtime_error(varExpr->VariableName + " can't be assigned at compile time.");
+		}
+		target = &it->second;
+	}
+	else if (auto strAccExpr = dynamic_cast<const StructAccessExpr*>(assign.LHS.get()))
+	{
+		object = Eval(*strAccExpr->LHS, frame);
+		target = &GetField(object, *strAccExpr->ResolvedSymbol);
+	}
+	else
+	{
+		throw std::runtime_error("This can't be assigned to at compile time.");
+	}
+
+	int64_t current = target->Int;
+	auto value = ConstEvaluator::EvaluateBinary(assign.Operator, current, Eval(*assign.Value, frame).Int);
+	if (!value)
+	{
+		throw std::runtime_error("Operator " + assign.Operator + "= can't be evaluated at compile time.");
+	}
+	target->Int = *value;
+}
+
+Overcast::Semantic::ConstValue Overcast::Semantic::Interpreter::MakeDefault(OCType* type)
+{
+	ConstValue value;
+	value.Type = type;
+	if (dynamic_cast<PointerType*>(type))
+		return value; // null
+
+	const auto typeName = type->to_string();
+	if (typeName == "int" || typeName == "bool")
+		return value;
+
+	const Binder::Symbol* structSymbol = FindStruct(typeName);
+	if (!structSymbol || structSymbol->Kind != Binder::SymbolKind::Struct)
+	{
+		throw std::runtime_error("Values of type " + typeName + " can't be made at compile time.");
+	}
+
+	value.Fields = std::make_shared<std::vector<ConstValue>>();
+	for (const auto& member : structSymbol->StructSymbols)
+	{
+		if (member.FieldIndex < 0)
+			continue;
+		if (value.Fields->size() <= static_cast<size_t>(member.FieldIndex))
+			value.Fields->resize(member.FieldIndex + 1);
+		(*value.Fields)[member.FieldIndex] = MakeDefault(member.Type);
+	}
+	return value;
+}
+
+Overcast::Semantic::ConstValue Overcast::Semantic::Interpreter::PassAs(const ConstValue& value, OCType* type)
+{
+	ConstValue passed = dynamic_cast<PointerType*>(type) ? value : value.Clone();
+	passed.Type = type;
+	return passed;
+}
+
+Overcast::Semantic::ConstValue& Overcast::Semantic::Interpreter::GetField(const ConstValue& object, const Binder::Symbol& member)
+{
+	if (!object.Fields)
+	{
+		throw std::runtime_error("Member " + member.Name + " accessed through a null pointer at compile time.");
+	}
+	if (member.FieldIndex < 0 || static_cast<size_t>(member.FieldIndex) >= object.Fields->size())
+	{
+		throw std::runtime_error(member.Name + " isn't a field that can be read at compile time.");
+	}
+	return (*object.Fields)[member.FieldIndex];
+}
+
+void Overcast::Semantic::Interpreter::Tick()
+{
+	if (Fuel == 0)
+	{
+		throw std::runtime_error("Compile-time evaluation ran out of fuel, is there an infinite loop?");
+	}
+	Fuel--;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Overcast/SyntaxAnalysis/statements.h"
+#include "Overcast/SyntaxAnalysis/expressions.h"
+#include "const_evaluator.h"
+#include "symbol_table.h"
+
+namespace Overcast::Semantic
+{
+	// runs bound function bodies at compile time so const initializers can call const funcs,
+	// it only knows ints, bools and structs of those, anything else is a compile error
+	class Interpreter
+	{
+	public:
+		using BodyLookup = std::function<const FunctionDeclStatement*(const Binder::Symbol*)>;
+		using StructLookup = std::function<const Binder::Symbol*(const std::string&)>;
+
+		static constexpr uint64_t DefaultFuel = 1 << 24; // statements + expressions it'll evaluate before giving up
+		static constexpr uint32_t MaxCallDepth = 128; // every interpreted call is a few native frames, keep it well off the stack limit
+
+		Interpreter(BodyLookup findBody, StructLookup findStruct, uint64_t fuel = DefaultFuel)
+			: FindBody(std::move(findBody)), FindStruct(std::move(findStruct)), Fuel(fuel)
+		{
+		}
+
+		ConstValue Evaluate(const Expression& expr);
+	private:
+		using Frame = std::unordered_map<const Binder::Symbol*, ConstValue>; // symbols are unique per declaration so one map per call does
+		enum class Flow
+		{
+			Normal,
+			Return
+		};
+
+		BodyLookup FindBody;
+		StructLookup FindStruct;
+		uint64_t Fuel;
+		uint32_t Depth = 0;
+
+		ConstValue Call(const Binder::Symbol& funcSymbol, std::vector<ConstValue>&& args);
+		Flow Execute(const std::vector<std::unique_ptr<Statement>>& block, Frame& frame, ConstValue& result);
+		Flow Execute(const Statement& stmt, Frame& frame, ConstValue& result);
+		ConstValue Eval(const Expression& expr, Frame& frame);
+		void Assign(const Expression& target, const ConstValue& value, Frame& frame);
+		void CompoundAssign(const CompoundAssignmentStatement& assign, Frame& frame);
+
+		ConstValue MakeDefault(OCType* type);
+		ConstValue PassAs(const ConstValue& value, OCType* type); // by-value structs get copied, pointers don't
+		ConstValue& GetField(const ConstValue& object, const Binder::Symbol& member);
+		void Tick();
+	};
+}
@@ -0,0 +1,66 @@
+#include "ocpch.h"
+#include "symbol_table.h"
+
+OCType* Overcast::Semantic::Binder::GetCanonicalType(OCType* type)
+{
+	auto identifier = dynamic_cast<IdentifierType*>(type);
+	if (!identifier)
+		return type;
+
+	const auto& name = identifier->TypeName;
+	if (name == "int")
+		return IdentifierType::GetIntType();
+	else if (name == "bool")
+		return IdentifierType::GetBoolType();
+	else if (name == "string")
+		return IdentifierType::GetStringType();
+	else if (name == "float")
+		return IdentifierType::GetFloatType();
+	else if (name == "void")
+		return IdentifierType::GetVoidType();
+	return type;
+}
+
+void Overcast::Semantic::Binder::GlobalSymbolIndex::Add(Symbol&& symbol)
+{
+	symbol.Type = GetCanonicalType(symbol.Type);
+	if (symbol.Kind == SymbolKind::Function)
+		symbol.LinkName = MakeFunctionLinkName(symbol.Name, symbol.IsExtern);
+
+	if (symbol.Kind == SymbolKind::Struct)
+	{
+		// the index owns the struct's type, member functions get their implicit 'this' like the binder gives them
+		OwnedTypes.push_back(std::make_unique<IdentifierType>(symbol.Name));
+		symbol.Type = OwnedTypes.back().get();
+
+		for (auto& member : symbol.StructSymbols)
+		{
+			member.Type = GetCanonicalType(member.Type);
+			if (member.Kind != SymbolKind::Function)
+				continue;
+
+			member.LinkName = MakeFunctionLinkName(member.Name, false, symbol.Name);
+
+			OwnedTypes.push_back(std::make_unique<PointerType>(std::make_unique<IdentifierType>(symbol.Name)));
+			member.ParamTypes.push_back(OwnedTypes.back().get());
+			member.ParamTypeNames.push_back(OwnedTypes.back()->to_string());
+			member.ParamCount = member.ParamTypes.size();
+			member.IsStructMemberFunc = true;
+		}
+
+		symbol.IndexStructMembers();
+	}
+
+	auto name = symbol.Name;
+	Names[name] = Symbols.Add(std::move(symbol));
+}
+
+void Overcast::Semantic::Binder::GlobalSymbolIndex::Freeze()
+{
+	VisibleSymbols.clear();
+	VisibleSymbols.reserve(Names.size());
+	for (const auto& [name, handle] : Names)
+	{
+		VisibleSymbols.push_back(&Symbols.Get(handle));
+	}
+}
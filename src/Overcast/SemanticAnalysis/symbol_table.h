@@ -0,0 +1,234 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Overcast/SyntaxAnalysis/types.h"
+
+class FunctionDeclStatement;
+
+namespace Overcast::Semantic
+{
+	struct ConstValue;
+}
+
+namespace Overcast::Semantic::Binder
+{
+	enum class SymbolKind
+	{
+		Variable,
+		Struct,
+		Function
+	};
+
+	struct Symbol
+	{
+		std::string Name;
+		SymbolKind Kind;
+
+		OCType* Type;
+
+		int ParamCount = 0; // for functions
+		std::vector<std::string> ParamTypeNames; // for functions, names of parameters
+		std::vector<OCType*> ParamTypes;
+		std::vector<Symbol> StructSymbols; // for structs, members of the struct
+		std::unordered_map<std::string, size_t> StructMemberIndex; // for structs, member name -> StructSymbols index
+		int FieldIndex = -1; // for struct fields, position in the struct's layout
+		std::string LinkName; // for functions, the name codegen emits
+		bool Variadic = false;
+		bool IsStructMemberFunc = false;
+		bool IsExtern = false;
+		bool IsBuiltin = false;
+		bool IsConst = false;
+		int64_t ConstValue = 0; // for int/bool consts, the folded initializer
+		std::shared_ptr<const Overcast::Semantic::ConstValue> ConstObject; // for struct consts, what the initializer evaluated to
+
+		Symbol() : Name(""), Kind(SymbolKind::Variable), Type(nullptr) {}
+		Symbol(const std::string& name, SymbolKind kind, OCType* type)
+			: Name(name), Kind(kind), Type(type)
+		{
+		}
+
+		// call once StructSymbols is complete, fields are numbered in declaration order like codegen lays them out
+		void IndexStructMembers()
+		{
+			StructMemberIndex.clear();
+			int field = 0;
+			for (size_t i = 0; i < StructSymbols.size(); i++)
+			{
+				if (StructSymbols[i].Kind == SymbolKind::Variable)
+					StructSymbols[i].FieldIndex = field++;
+				StructMemberIndex.insert({ StructSymbols[i].Name, i });
+			}
+		}
+
+		const Symbol* FindStructMember(const std::string& name) const
+		{
+			auto it = StructMemberIndex.find(name);
+			if (it == StructMemberIndex.end())
+				return nullptr;
+			return &StructSymbols[it->second];
+		}
+	};
+
+	// the name a function is emitted under
+	inline std::string MakeFunctionLinkName(const std::string& name, bool isExtern, const std::string& structName = "")
+	{
+		if (isExtern || name == "main")
+			return name;
+		if (!structName.empty())
+			return "func:" + structName + "::" + name;
+		return "func:" + name;
+	}
+
+	// maps primitive types onto their shared instances so equal types are the same pointer
+	OCType* GetCanonicalType(OCType* type);
+
+	using SymbolHandle = uint32_t;
+	constexpr SymbolHandle InvalidSymbolHandle = UINT32_MAX;
+
+	// owns every symbol a binder creates, lookups hand out handles/pointers into it instead of copies
+	class SymbolArena
+	{
+	public:
+		SymbolHandle Add(Symbol&& symbol)
+		{
+			Symbols.push_back(std::move(symbol));
+			return static_cast<SymbolHandle>(Symbols.size() - 1);
+		}
+
+		const Symbol& Get(SymbolHandle handle) const
+		{
+			return Symbols[handle];
+		}
+
+		size_t Size() const
+		{
+			return Symbols.size();
+		}
+	private:
+		std::deque<Symbol> Symbols; // a deque so references stay valid while the arena grows
+	};
+
+	using NameId = uint32_t;
+
+	// one table for every scope, each interned name points at its innermost binding and the bindings it shadows
+	// are kept in an undo log, so entering/exiting a scope is just pushing/popping a marker
+	class ScopedSymbolTable
+	{
+	public:
+		void EnterScope()
+		{
+			ScopeMarks.push_back(UndoLog.size());
+		}
+
+		bool ExitScope()
+		{
+			if (ScopeMarks.empty())
+				return false;
+
+			size_t mark = ScopeMarks.back();
+			ScopeMarks.pop_back();
+			while (UndoLog.size() > mark)
+			{
+				const auto& entry = UndoLog.back();
+				Heads[entry.Name] = entry.Previous;
+				UndoLog.pop_back();
+			}
+			return true;
+		}
+
+		uint32_t Depth() const
+		{
+			return static_cast<uint32_t>(ScopeMarks.size());
+		}
+
+		// binds the name in the innermost scope, returns false if that scope already has it
+		bool Bind(const std::string& name, SymbolHandle handle)
+		{
+			NameId id = Intern(name);
+			if (Heads[id].Symbol != InvalidSymbolHandle && Heads[id].Depth == Depth())
+				return false;
+
+			UndoLog.push_back({ id, Heads[id] });
+			Heads[id] = { handle, Depth() };
+			return true;
+		}
+
+		SymbolHandle Lookup(const std::string& name) const
+		{
+			auto it = Names.find(name);
+			if (it == Names.end())
+				return InvalidSymbolHandle;
+			return Heads[it->second].Symbol;
+		}
+
+		bool IsBoundInCurrentScope(const std::string& name) const
+		{
+			auto it = Names.find(name);
+			if (it == Names.end())
+				return false;
+			const auto& head = Heads[it->second];
+			return head.Symbol != InvalidSymbolHandle && head.Depth == Depth();
+		}
+	private:
+		struct Binding
+		{
+			SymbolHandle Symbol = InvalidSymbolHandle;
+			uint32_t Depth = 0;
+		};
+
+		struct UndoEntry
+		{
+			NameId Name;
+			Binding Previous;
+		};
+
+		std::unordered_map<std::string, NameId> Names;
+		std::vector<Binding> Heads; // indexed by NameId
+		std::vector<UndoEntry> UndoLog;
+		std::vector<size_t> ScopeMarks;
+
+		NameId Intern(const std::string& name)
+		{
+			auto it = Names.find(name);
+			if (it != Names.end())
+				return it->second;
+
+			NameId id = static_cast<NameId>(Heads.size());
+			Names.insert({ name, id });
+			Heads.push_back({});
+			return id;
+		}
+	};
+
+	// every file's top-level symbols, built once per build and then only ever read (from any thread),
+	// binders layer their own scopes on top of it instead of copying it
+	class GlobalSymbolIndex
+	{
+	public:
+		// later symbols with the same name shadow earlier ones
+		void Add(Symbol&& symbol);
+		void Freeze();
+
+		const Symbol* Find(const std::string& name) const
+		{
+			auto it = Names.find(name);
+			if (it == Names.end())
+				return nullptr;
+			return &Symbols.Get(it->second);
+		}
+
+		const std::vector<const Symbol*>& GetSymbols() const
+		{
+			return VisibleSymbols;
+		}
+	private:
+		SymbolArena Symbols;
+		std::unordered_map<std::string, SymbolHandle> Names;
+		std::vector<const Symbol*> VisibleSymbols;
+		std::vector<std::unique_ptr<OCType>> OwnedTypes; // struct types and their implicit 'this' types
+	};
+}
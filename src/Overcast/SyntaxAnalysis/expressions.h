@@ -1,9 +1,15 @@
 #pragma once
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <memory>
 #include "types.h"
 
+namespace Overcast::Semantic::Binder
+{
+	struct Symbol;
+}
+
 class Expression
 {
 public:
@@ -11,6 +17,7 @@ public:
 	{
 		None,
 		Int,
+		Bool,
 		Float,
 		String,
 		Variable,
@@ -24,6 +31,14 @@ public:
 
 	Type m_Type = Type::None;
 
+	// the binder sets these, codegen reads them instead of resolving names again
+	const Overcast::Semantic::Binder::Symbol* ResolvedSymbol = nullptr;
+	OCType* ResolvedType = nullptr;
+
+	// set by the binder when it could fold this (int and bool only), codegen then emits the value directly
+	bool IsConstant = false;
+	int64_t ConstantValue = 0;
+
 	virtual ~Expression() {}
 };
 
@@ -39,6 +54,18 @@ public:
 	}
 };
 
+class BoolLiteralExpr : public Expression
+{
+public:
+	bool LiteralValue;
+
+	BoolLiteralExpr(bool value)
+		: LiteralValue(value)
+	{
+		m_Type = Type::Bool;
+	}
+};
+
 class FloatLiteralExpr : public Expression
 {
 public:
@@ -67,7 +94,6 @@ class VariableUseExpr : public Expression
 {
 public:
 	std::string VariableName;
-	bool isFunc = false; // the binder sets this
 	VariableUseExpr(const std::string& varName)
 		: VariableName(varName)
 	{
@@ -100,7 +126,6 @@ class InvokeFunctionExpr : public Expression
 public:
 	std::unique_ptr<Expression> InvokedFunction;
 	std::vector<std::unique_ptr<Expression>> Arguments;
-	bool IsStructFunc = false;
 
 	InvokeFunctionExpr(std::unique_ptr<Expression> funcExpr, std::vector<std::unique_ptr<Expression>>&& args)
 		: InvokedFunction(std::move(funcExpr)), Arguments(std::move(args))
@@ -115,6 +140,8 @@ public:
 	std::unique_ptr<Expression> LHS;
 	std::string MemberName;
 
+	const Overcast::Semantic::Binder::Symbol* ResolvedStruct = nullptr; // the binder sets this, ResolvedSymbol is the member
+
 	StructAccessExpr(std::unique_ptr<Expression> lhs, const std::string& memberName)
 		: LHS(std::move(lhs)), MemberName(memberName)
 	{
@@ -127,6 +154,8 @@ class StructCtorExpr : public Expression
 public:
 	std::string StructTypeName;
 	std::vector<std::unique_ptr<Expression>> Arguments;
+	const Overcast::Semantic::Binder::Symbol* ResolvedCtor = nullptr; // the binder sets this, null means the default ctor
+	bool Escapes = true; // escape analysis clears this when the object can live in the function's frame
 
 	StructCtorExpr(const std::string& structTypeName, std::vector<std::unique_ptr<Expression>>&& args)
 		: StructTypeName(structTypeName), Arguments(std::move(args))
@@ -8,7 +8,10 @@ std::vector<std::unique_ptr<Statement>> Overcast::Parser::Parser::Parse()
 	{
 		while (currentToken != Tokens->end())
 		{
-			ResultVector.push_back(std::move(ParseStatement()));
+			auto statement = ParseStatement();
+			if (statement->m_Type == Statement::Type::ConstDecl) // file-level consts end with a semicolon too
+				Match(TokenType::SYMBOL, ";");
+			ResultVector.push_back(std::move(statement));
 		}
 	}
 
@@ -19,7 +22,7 @@ std::unique_ptr<Expression> Overcast::Parser::Parser::ParseExpression(int preced
 {
 	auto lhs = ParsePostfixExpression();
     Token tokenCopy = *currentToken; // to avoid a really weird issue
-    while (currentToken->Type == TokenType::OPERATOR && currentToken->Lexeme != "=" && GetPrecedence(tokenCopy) >= precedence)
+    while (currentToken->Type == TokenType::OPERATOR && !IsAssignmentOperator(currentToken->Lexeme) && GetPrecedence(tokenCopy) >= precedence)
     {
         auto op = Match(TokenType::OPERATOR);
         auto opPrec = GetPrecedence(op);
@@ -51,6 +54,8 @@ std::unique_ptr <Expression> Overcast::Parser::Parser::ParsePrimaryExpression()
     }
     case TokenType::IDENTIFIER:
     {
+        if (currentToken->Lexeme == "true" || currentToken->Lexeme == "false")
+            return ParseBoolLiteralExpr();
         return ParseVariableExpr();
     }
 	case TokenType::KEYWORD:
@@ -133,6 +138,8 @@ std::unique_ptr<Statement> Overcast::Parser::Parser::ParseStatement()
             }
             else if (currentToken->Lexeme == "const") // const decl statement
             {
+                if (Peek().Lexeme == "func") // or a const func
+                    return ParseFunctionDeclStatement();
                 return ParseConstDeclStatement();
             }
 			else if (currentToken->Lexeme == "if") // if statement
@@ -143,11 +150,31 @@ std::unique_ptr<Statement> Overcast::Parser::Parser::ParseStatement()
 			{
 				return ParseWhileStatement();
 			}
+			else if (currentToken->Lexeme == "for") // counted loop statement
+			{
+				return ParseForStatement();
+			}
 			else if (currentToken->Lexeme == "use") 
 			{
                 Match(TokenType::KEYWORD, "use");
                 return std::make_unique<UseStatement>(Match(TokenType::IDENTIFIER).Lexeme);
 			}
+            else if (currentToken->Lexeme == "export") // export func/struct, visible to other files and the linker
+            {
+                Match(TokenType::KEYWORD, "export");
+                auto exported = ParseStatement();
+                if (auto funcDecl = dynamic_cast<FunctionDeclStatement*>(exported.get()))
+                    funcDecl->IsExported = true;
+                else if (auto structDecl = dynamic_cast<StructDeclStatement*>(exported.get()))
+                {
+                    structDecl->IsExported = true;
+                    for (auto& memberFunc : structDecl->MemberFunctions)
+                        memberFunc->IsExported = true;
+                }
+                else
+                    throw SyntaxError("Only functions and structs can be exported.");
+                return exported;
+            }
             else if (currentToken->Lexeme == "package")
             {
                 Match(TokenType::KEYWORD, "package");
@@ -160,7 +187,7 @@ std::unique_ptr<Statement> Overcast::Parser::Parser::ParseStatement()
             {
                 return std::make_unique<ExpressionStatement>(std::move(ParseExpression()));
             }
-            else if (Peek().Lexeme == "=")
+            else if (IsAssignmentOperator(Peek().Lexeme))
             {
 				return ParseAssignmentStatement();
 			}
@@ -172,6 +199,12 @@ std::unique_ptr<Statement> Overcast::Parser::Parser::ParseStatement()
                     return ParseAssignmentStatement(); // cuz then it's this->x = a lol
             }
             break;
+        case TokenType::SYMBOL:
+            if (currentToken->Lexeme == "#") // attributes, they belong to whatever statement follows
+            {
+                return ParseAttributedStatement();
+            }
+            break;
     }
 
     throw std::runtime_error("Failed to find a valid statement.");
@@ -214,7 +247,7 @@ std::vector<std::unique_ptr<Statement>> Overcast::Parser::Parser::ParseBlockStat
     while (currentToken->Lexeme != "}")
     {
         auto statement = ParseStatement();
-        if (statement->m_Type != Statement::Type::If && statement->m_Type != Statement::Type::While)
+        if (statement->m_Type != Statement::Type::If && statement->m_Type != Statement::Type::While && statement->m_Type != Statement::Type::For)
         {
             Match(TokenType::SYMBOL, ";");
         }
@@ -230,7 +263,14 @@ std::unique_ptr<FunctionDeclStatement> Overcast::Parser::Parser::ParseFunctionDe
 {
     // keyword identifier '(' params?... ')' arrow(->) (body?) (;?)
     bool externFunc = false;
-	if (currentToken->Lexeme == "extern")
+    bool constFunc = false;
+    if (currentToken->Lexeme == "const")
+    {
+        Match(TokenType::KEYWORD, "const");
+        constFunc = true;
+    }
+
+	if (!constFunc && currentToken->Lexeme == "extern")
 	{
 		Match(TokenType::KEYWORD, "extern");
         externFunc = true;
@@ -265,7 +305,9 @@ std::unique_ptr<FunctionDeclStatement> Overcast::Parser::Parser::ParseFunctionDe
     if (!externFunc)
     {
         auto body = ParseBlockStatement();
-        return std::make_unique<FunctionDeclStatement>(name, std::move(returnType), params, std::move(body));
+        auto func = std::make_unique<FunctionDeclStatement>(name, std::move(returnType), params, std::move(body));
+        func->IsConstFunc = constFunc;
+        return func;
     }
     else
     {
@@ -302,9 +344,20 @@ std::unique_ptr<VariableDeclStatement> Overcast::Parser::Parser::ParseVarDeclSta
     }
 }
 
-std::unique_ptr<AssignmentStatement> Overcast::Parser::Parser::ParseAssignmentStatement()
+std::unique_ptr<Statement> Overcast::Parser::Parser::ParseAssignmentStatement()
 {
     auto assignee = ParseExpression();
+    if (currentToken->Lexeme != "=" && IsAssignmentOperator(currentToken->Lexeme)) // x op= y
+    {
+        auto op = Match(TokenType::OPERATOR).Lexeme;
+        auto binaryOp = op.substr(0, op.size() - 1);
+        if (binaryOp != "+" && binaryOp != "-" && binaryOp != "*" && binaryOp != "/" && binaryOp != "%")
+            throw SyntaxError("Operator " + op + " is not supported, at line " + std::to_string(currentToken->line) + ".");
+
+        auto value = ParseExpression();
+        return std::make_unique<CompoundAssignmentStatement>(std::move(assignee), binaryOp, std::move(value));
+    }
+
 	Match(TokenType::OPERATOR, "=");
 	auto value = ParseExpression();
 	return std::make_unique<AssignmentStatement>(std::move(assignee), std::move(value));
@@ -320,7 +373,7 @@ std::unique_ptr<StructDeclStatement> Overcast::Parser::Parser::ParseStructDeclSt
     std::vector<Parameter> members;
 	std::vector<std::unique_ptr<FunctionDeclStatement>> memberFunctions;
 
-    while (currentToken->Lexeme != "func" && currentToken->Lexeme != "}")
+    while (currentToken->Lexeme != "func" && currentToken->Lexeme != "#" && currentToken->Lexeme != "}")
     {
         auto memberName = Match(TokenType::IDENTIFIER).Lexeme;
         Match(TokenType::SYMBOL, ":");
@@ -331,11 +384,13 @@ std::unique_ptr<StructDeclStatement> Overcast::Parser::Parser::ParseStructDeclSt
         Match(TokenType::SYMBOL, ";");
     }
 
-	if (currentToken->Lexeme == "func")
+	if (currentToken->Lexeme == "func" || currentToken->Lexeme == "#")
 	{
-		while (currentToken->Lexeme == "func")
+		while (currentToken->Lexeme == "func" || currentToken->Lexeme == "#")
 		{
+			auto attributes = ParseAttributes();
 			memberFunctions.push_back(ParseFunctionDeclStatement());
+			memberFunctions.back()->Attributes = std::move(attributes);
 		}
 
         if (currentToken->Lexeme != "func" && currentToken->Lexeme != "}") {
@@ -382,6 +437,55 @@ std::unique_ptr<WhileStatement> Overcast::Parser::Parser::ParseWhileStatement()
     return std::make_unique<WhileStatement>(std::move(condition), std::move(body));
 }
 
+std::unique_ptr<ForStatement> Overcast::Parser::Parser::ParseForStatement()
+{
+    // 'for' '(' (identifier ':' type '=' expr | assignment)? ';' expr? ';' assignment? ')' block
+    // 'for' '(' identifier ':' type 'in' expr '..' expr ')' block
+    Match(TokenType::KEYWORD, "for");
+    Match(TokenType::SYMBOL, "(");
+
+    std::unique_ptr<Statement> init;
+    if (currentToken->Type == TokenType::IDENTIFIER && Peek().Lexeme == ":") // declares the loop var
+    {
+        auto varName = Match(TokenType::IDENTIFIER).Lexeme;
+        Match(TokenType::SYMBOL, ":");
+        auto varType = ParseType();
+
+        if (currentToken->Lexeme == "in") // range form, turned into the counted one right here
+        {
+            Match(TokenType::IDENTIFIER, "in");
+            auto first = ParseExpression();
+            Match(TokenType::SYMBOL, ".");
+            Match(TokenType::SYMBOL, ".");
+            auto last = ParseExpression(); // exclusive
+            Match(TokenType::SYMBOL, ")");
+            auto body = ParseBlockStatement();
+
+            auto condition = std::make_unique<BinaryExpr>(std::make_unique<VariableUseExpr>(varName), "<", std::move(last));
+            auto step = std::make_unique<CompoundAssignmentStatement>(std::make_unique<VariableUseExpr>(varName), "+", std::make_unique<IntLiteralExpr>(1));
+            return std::make_unique<ForStatement>(std::make_unique<VariableDeclStatement>(varName, std::move(varType), true, std::move(first)),
+                std::move(condition), std::move(step), std::move(body));
+        }
+
+        Match(TokenType::OPERATOR, "=");
+        init = std::make_unique<VariableDeclStatement>(varName, std::move(varType), true, ParseExpression());
+    }
+    else if (currentToken->Lexeme != ";")
+    {
+        init = ParseAssignmentStatement();
+    }
+    Match(TokenType::SYMBOL, ";");
+
+    std::unique_ptr<Expression> condition = currentToken->Lexeme != ";" ? ParseExpression() : nullptr;
+    Match(TokenType::SYMBOL, ";");
+
+    std::unique_ptr<Statement> step = currentToken->Lexeme != ")" ? ParseAssignmentStatement() : nullptr;
+    Match(TokenType::SYMBOL, ")");
+
+    auto body = ParseBlockStatement();
+    return std::make_unique<ForStatement>(std::move(init), std::move(condition), std::move(step), std::move(body));
+}
+
 std::unique_ptr<ReturnStatement> Overcast::Parser::Parser::ParseReturnStatement()
 {
 	Match(TokenType::KEYWORD, "return");
@@ -389,9 +493,54 @@ std::unique_ptr<ReturnStatement> Overcast::Parser::Parser::ParseReturnStatement(
     return std::make_unique<ReturnStatement>(std::move(returnValue));
 }
 
+std::vector<StatementAttribute> Overcast::Parser::Parser::ParseAttributes()
+{
+    // ('#' identifier ('(' int (',' int)* ')')?)*
+    std::vector<StatementAttribute> attributes;
+    while (currentToken->Lexeme == "#")
+    {
+        Match(TokenType::SYMBOL, "#");
+        StatementAttribute attribute{ Match(TokenType::IDENTIFIER).Lexeme, {} };
+        if (currentToken->Lexeme == "(")
+        {
+            Match(TokenType::SYMBOL, "(");
+            while (currentToken->Lexeme != ")")
+            {
+                attribute.Arguments.push_back(std::atoll(Match(TokenType::INTEGER).Lexeme.c_str()));
+                if (currentToken->Lexeme == ",")
+                    Match(TokenType::SYMBOL, ",");
+            }
+            Match(TokenType::SYMBOL, ")");
+        }
+        attributes.push_back(std::move(attribute));
+    }
+    return attributes;
+}
+
+std::unique_ptr<Statement> Overcast::Parser::Parser::ParseAttributedStatement()
+{
+    auto attributes = ParseAttributes();
+    auto statement = ParseStatement();
+    statement->Attributes.insert(statement->Attributes.end(), attributes.begin(), attributes.end());
+    return statement;
+}
+
 std::unique_ptr<ConstDeclStatement> Overcast::Parser::Parser::ParseConstDeclStatement()
 {
-    return std::unique_ptr<ConstDeclStatement>();
+    // keyword identifier ':' type '=' expr
+
+    Match(TokenType::KEYWORD, "const");
+    auto constName = Match(TokenType::IDENTIFIER).Lexeme;
+    Match(TokenType::SYMBOL, ":");
+    auto constType = ParseType();
+    if (currentToken->Lexeme != "=") // consts have to be initialized
+    {
+        throw SyntaxError("Expected '=' after constant declaration, got " + currentToken->Lexeme + " at line " + std::to_string(currentToken->line) + ", column " + std::to_string(currentToken->col) + ".");
+    }
+
+    Match(TokenType::OPERATOR, "=");
+    auto value = ParseExpression();
+    return std::make_unique<ConstDeclStatement>(constName, std::move(constType), std::move(value));
 }
 
 // EXPRESSION PARSING
@@ -401,6 +550,11 @@ std::unique_ptr<IntLiteralExpr> Overcast::Parser::Parser::ParseIntLiteralExpr()
     return std::make_unique<IntLiteralExpr>(std::atoi(Match(TokenType::INTEGER).Lexeme.c_str()));
 }
 
+std::unique_ptr<BoolLiteralExpr> Overcast::Parser::Parser::ParseBoolLiteralExpr()
+{
+    return std::make_unique<BoolLiteralExpr>(Match(TokenType::IDENTIFIER).Lexeme == "true");
+}
+
 std::unique_ptr<FloatLiteralExpr> Overcast::Parser::Parser::ParseFloatLiteralExpr()
 {
     return nullptr;
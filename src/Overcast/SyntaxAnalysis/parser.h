@@ -36,14 +36,18 @@ namespace Overcast::Parser
 		std::vector<std::unique_ptr<Statement>> ParseBlockStatement();
 		std::unique_ptr<FunctionDeclStatement> ParseFunctionDeclStatement();
 		std::unique_ptr<VariableDeclStatement> ParseVarDeclStatement();
-		std::unique_ptr<AssignmentStatement> ParseAssignmentStatement();
+		std::unique_ptr<Statement> ParseAssignmentStatement(); // plain or compound
 		std::unique_ptr<StructDeclStatement> ParseStructDeclStatement();
 		std::unique_ptr<IfStatement> ParseIfStatement();
 		std::unique_ptr<WhileStatement> ParseWhileStatement();
+		std::unique_ptr<ForStatement> ParseForStatement();
 		std::unique_ptr<ReturnStatement> ParseReturnStatement();
 		std::unique_ptr<ConstDeclStatement> ParseConstDeclStatement();
+		std::unique_ptr<Statement> ParseAttributedStatement();
+		std::vector<StatementAttribute> ParseAttributes();
 
 		std::unique_ptr<IntLiteralExpr> ParseIntLiteralExpr();
+		std::unique_ptr<BoolLiteralExpr> ParseBoolLiteralExpr();
 		std::unique_ptr<FloatLiteralExpr> ParseFloatLiteralExpr();
 		std::unique_ptr<StringLiteralExpr> ParseStringLiteralExpr();
 		std::unique_ptr<VariableUseExpr> ParseVariableExpr();
@@ -99,6 +103,15 @@ namespace Overcast::Parser
 			return -1;
 		}
 
+		inline bool IsAssignmentOperator(const std::string& op) {
+			static const std::unordered_set<std::string> assignmentOps = {
+				"=",
+				"+=", "-=", "*=", "/=", "%=", "&=", "|=", "^="
+			};
+
+			return assignmentOps.count(op) > 0;
+		}
+
 		inline bool IsRightAssociative(const std::string& op) {
 			static const std::unordered_set<std::string> rightAssociativeOps = {
 				"=",
@@ -4,6 +4,13 @@
 #include "types.h"
 #include "expressions.h"
 
+// #name or #name(1, 2) in front of a statement, e.g. #inline on a func
+struct StatementAttribute
+{
+	std::string Name;
+	std::vector<int64_t> Arguments;
+};
+
 class Statement
 {
 public:
@@ -14,14 +21,27 @@ public:
 		ConstDecl,
 		Return,
 		Assignment,
+		CompoundAssignment,
 		If,
 		While,
+		For,
 		PackageDecl,
 		Use,
 		StructDecl,
 		Expression // As in Expression Statements
 	};
 	Type m_Type;
+	std::vector<StatementAttribute> Attributes;
+
+	const StatementAttribute* FindAttribute(const std::string& name) const
+	{
+		for (const auto& attribute : Attributes)
+		{
+			if (attribute.Name == name)
+				return &attribute;
+		}
+		return nullptr;
+	}
 
 	Statement(Type type)
 		: m_Type(type)
@@ -41,6 +61,7 @@ struct Parameter
 {
 	std::unique_ptr<OCType> ParameterType;
 	std::string ParameterName;
+	const Overcast::Semantic::Binder::Symbol* ResolvedSymbol = nullptr; // the binder sets this
 
 	Parameter(std::unique_ptr<OCType>&& type, const std::string& name)
 		: ParameterType(std::move(type)), ParameterName(name)
@@ -49,7 +70,7 @@ struct Parameter
 
 	Parameter(const Parameter& other)
 		: ParameterType(other.ParameterType ? other.ParameterType->clone() : nullptr),
-		ParameterName(other.ParameterName)
+		ParameterName(other.ParameterName), ResolvedSymbol(other.ResolvedSymbol)
 	{
 	}
 
@@ -59,6 +80,7 @@ struct Parameter
 		{
 			ParameterType = other.ParameterType ? other.ParameterType->clone() : nullptr;
 			ParameterName = other.ParameterName;
+			ResolvedSymbol = other.ResolvedSymbol;
 		}
 		return *this;
 	}
@@ -72,10 +94,24 @@ class FunctionDeclStatement : public Statement
 public:
 	std::string FuncName;
 	bool IsExtern = false;
+	bool IsConstFunc = false; // callable at compile time
+	bool IsExported = false; // keeps external linkage even if no other file calls it
 	std::unique_ptr<OCType> ReturnType;
 	std::vector<Parameter> Parameters;
 	std::vector<std::unique_ptr<Statement>> Body;
 	bool IsStructMember = false; // only for the binder
+	const Overcast::Semantic::Binder::Symbol* ResolvedSymbol = nullptr; // the binder sets this
+
+	// what the binder could prove about the body (see AttributeInference), codegen turns it into llvm attributes
+	struct InferredAttributes
+	{
+		bool ReadsMemory = true; // through a pointer, a field or a const object
+		bool WritesMemory = true; // anything but the function's own locals
+		bool CallsFunctions = true; // other than builtins
+		bool CallsBuiltins = true;
+		bool HasLoops = true;
+		std::vector<bool> NoAliasParams; // per parameter, 'this' included
+	} Inferred;
 
 	// Disable copy
 	FunctionDeclStatement(const FunctionDeclStatement&) = delete;
@@ -100,6 +136,7 @@ public:
 	std::unique_ptr<OCType> VariableType;
 	bool Defined;
 	std::unique_ptr<Expression> DefaultValue;
+	const Overcast::Semantic::Binder::Symbol* ResolvedSymbol = nullptr; // the binder sets this
 
 	VariableDeclStatement() = default;
 
@@ -123,12 +160,27 @@ public:
 	}
 };
 
+// x op= y, the target is only evaluated once
+class CompoundAssignmentStatement : public Statement
+{
+public:
+	std::unique_ptr<Expression> LHS;
+	std::string Operator; // the binary op, "+" for +=
+	std::unique_ptr<Expression> Value;
+
+	CompoundAssignmentStatement(std::unique_ptr<Expression> lhs, const std::string& op, std::unique_ptr<Expression> value)
+		: Statement{ Type::CompoundAssignment }, LHS(std::move(lhs)), Operator(op), Value(std::move(value))
+	{
+	}
+};
+
 class StructDeclStatement : public Statement
 {
 public:
 	std::string StructName;
 	std::vector<Parameter> Members;
 	std::vector<std::unique_ptr<FunctionDeclStatement>> MemberFunctions;
+	bool IsExported = false; // exports every member function
 
 	StructDeclStatement(const std::string& structName, const std::vector<Parameter>& members)
 		: Statement{ Type::StructDecl }, StructName(structName), Members(members)
@@ -159,19 +211,33 @@ public:
 	}
 };
 
+// for (i: int = 0; i < n; i += 1) { ... }, any of the three parts can be left out
+// for (i: int in a..b) { ... } is parsed into for (i: int = a; i < b; i += 1), so b is checked before every iteration
+class ForStatement : public Statement
+{
+public:
+	std::unique_ptr<Statement> Init; // a var decl or an assignment, a var declared here only lives for the loop
+	std::unique_ptr<Expression> Condition; // null loops until something returns
+	std::unique_ptr<Statement> Step; // an assignment or compound assignment, runs after every iteration
+	std::vector<std::unique_ptr<Statement>> Body;
+	ForStatement(std::unique_ptr<Statement> init, std::unique_ptr<Expression> condition, std::unique_ptr<Statement> step, std::vector<std::unique_ptr<Statement>>&& body)
+		: Statement{ Type::For }, Init(std::move(init)), Condition(std::move(condition)), Step(std::move(step)), Body(std::move(body))
+	{
+	}
+};
+
 class ConstDeclStatement : public Statement
 {
 public:
 	std::string VarName;
 	std::unique_ptr<OCType> VariableType;
-	Expression DefaultValue;
+	std::unique_ptr<Expression> DefaultValue;
+	const Overcast::Semantic::Binder::Symbol* ResolvedSymbol = nullptr; // the binder sets this
 
-	ConstDeclStatement(const std::string& VarName, std::unique_ptr<OCType>&& VariableType, const Expression& DefaultValue)
-		: Statement{ Type::ConstDecl }, VarName(VarName), VariableType(std::move(VariableType)), DefaultValue(DefaultValue)
+	ConstDeclStatement(const std::string& VarName, std::unique_ptr<OCType>&& VariableType, std::unique_ptr<Expression>&& DefaultValue)
+		: Statement{ Type::ConstDecl }, VarName(VarName), VariableType(std::move(VariableType)), DefaultValue(std::move(DefaultValue))
 	{
 	}
-
-	ConstDeclStatement() = default;
 };
 
 class PackageDeclStatement : public Statement
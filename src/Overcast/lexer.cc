@@ -7,7 +7,7 @@ const std::unordered_map<TokenType, std::regex> tokenPatterns = {
 	{ TokenType::IDENTIFIER, std::regex("[a-zA-Z_][a-zA-Z0-9_]*") },
 	{ TokenType::ARROW, std::regex("(->|<-)") },
 	{ TokenType::OPERATOR, std::regex("(==|!=|<=|>=|\\+=|-=|\\*=|/=|&&|\\|\\||\\+\\+|--|%=|&=|\\|=|\\^=|[+\\-*/=<>!&|^%])") },
-	{ TokenType::SYMBOL, std::regex("[\\/<>!&|^%(){}\\[\\],.:;]") },
+	{ TokenType::SYMBOL, std::regex("[\\/<>!&|^%(){}\\[\\],.:;#]") },
 	{ TokenType::INTEGER, std::regex("\\b[0-9]+\\b") },
 	{ TokenType::STRING, std::regex("\".*?\"") },
 	{ TokenType::COMMENT, std::regex("//.*?\\n") },
@@ -43,7 +43,7 @@ void create_project(std::string name, bool nostd, bool noal, bool emit_llvm)
 	std::cout << "Created project " << name << std::endl;
 }
 
-void build_project(std::string projectName, int threadCount)
+void build_project(std::string projectName, int threadCount, std::string configuration, std::string optLevel, std::string cpu, std::string features, int splitParts, std::string lto, bool wholeProgram)
 {
 	auto startTime = std::chrono::high_resolution_clock::now();
 	std::filesystem::path cwd = std::filesystem::current_path();
@@ -77,7 +77,50 @@ void build_project(std::string projectName, int threadCount)
 	std::string projectTOML(std::istreambuf_iterator<char>(inFile), {});
 	auto project = Overcast::ProjectSystem::Project::LoadFromTOML(projectTOML);
 
-	std::cout << "Building project " << project.ProjectName << "..." << std::endl;
+	Overcast::CodeGen::CodeGenOptions options;
+	try
+	{
+		options = project.GetCodeGenOptions(configuration);
+	}
+	catch (std::runtime_error& error)
+	{
+		std::cerr << error.what() << std::endl;
+		return;
+	}
+
+	// -O on the command line wins over both the configuration and the project
+	if (!optLevel.empty())
+	{
+		auto level = Overcast::CodeGen::ParseOptLevel(optLevel);
+		if (!level)
+		{
+			std::cerr << "Invalid optimization level " << optLevel << ", expected one of O0/O1/O2/O3/Os/Oz." << std::endl;
+			return;
+		}
+		options.Level = *level;
+	}
+
+	if (!cpu.empty())
+		options.CPU = cpu;
+	if (!features.empty())
+		options.Features = features;
+	if (splitParts > 0)
+		options.SplitParts = static_cast<uint32_t>(splitParts);
+	if (!lto.empty())
+	{
+		auto mode = Overcast::CodeGen::ParseLTOMode(lto);
+		if (!mode)
+		{
+			std::cerr << "Invalid LTO mode " << lto << ", expected none or thin." << std::endl;
+			return;
+		}
+		options.LTO = *mode;
+	}
+	if (wholeProgram)
+		options.WholeProgram = true;
+	Overcast::CodeGen::ResolveHostTarget(options);
+
+	std::cout << "Building project " << project.ProjectName << " (" << configuration << ")..." << std::endl;
 	std::cout << "Discovering source files..." << std::endl;
 
 	for (std::filesystem::recursive_directory_iterator i(cwd, std::filesystem::directory_options::skip_permission_denied), end; i != end; ++i)
@@ -90,7 +133,7 @@ void build_project(std::string projectName, int threadCount)
 	}
 
 	std::cout << "Building..." << std::endl;
-	auto buildResult = buildSystem.RunBuild(project.ProjectName);
+	auto buildResult = buildSystem.RunBuild(project.ProjectName, options, threadCount);
 	std::cout << buildResult.BuildMessage << std::endl;
 	if (!buildResult.IsSuccess())
 	{
@@ -109,13 +152,19 @@ int main(int argc, char* argv[])
 {
 	try
 	{
-		cxxopts::Options opts("overcast", "[build/create/clean] (project name)? (-emit-llvm/-no_std/-no_autolink)? (-c [Debug/Release]) (-t <thread count>)?");
+		cxxopts::Options opts("overcast", "[build/create/clean] (project name)? (-emit-llvm/-no_std/-no_autolink)? (-c [Debug/Release]) (-O [0/1/2/3/s/z])? (--mcpu <cpu/native>)? (--mattr <+feature,-feature>)? (--split <parts>)? (--flto=[thin/none])? (--whole-program)? (-t <thread count>)?");
 
 		opts.add_options()
 			("emit-llvm", "Emit LLVM IR")          
 			("no_std", "Disable standard library")   
 			("no_autolink", "Disable autolink")  
 			("c", "Set configuration for build", cxxopts::value<std::string>()->default_value("Debug"))
+			("O", "Optimization level, overrides the configuration and project (0/1/2/3/s/z)", cxxopts::value<std::string>())
+			("mcpu", "Target CPU, native builds for this machine", cxxopts::value<std::string>())
+			("mattr", "Target features to add (+name) or remove (-name), comma separated", cxxopts::value<std::string>())
+			("split", "Split each file's module into this many parts for the backend", cxxopts::value<int>())
+			("flto", "Link time optimization across files (thin/none)", cxxopts::value<std::string>())
+			("whole-program", "Compile every file into one module and optimize them together")
 			("t", "Thread count", cxxopts::value<int>()->default_value(std::to_string(std::thread::hardware_concurrency())))
 			("help", "Print help");
 
@@ -149,10 +198,20 @@ int main(int argc, char* argv[])
 			else if (command == "build")
 			{
 				std::string projectName = result["project"].as<std::string>();
-				int threadCount = std::thread::hardware_concurrency();
-				if(result.count("t,threads"))
-					threadCount = result["t,threads"].as<int>();
-				build_project(projectName, threadCount);
+				int threadCount = std::max(1u, std::thread::hardware_concurrency()); // it's allowed to say 0 when it doesn't know
+				if(result.count("t"))
+					threadCount = result["t"].as<int>();
+				if (threadCount < 1)
+				{
+					std::cerr << "Invalid thread count " << threadCount << ", at least 1 thread is needed." << std::endl;
+					return -1;
+				}
+				std::string optLevel = result.count("O") ? result["O"].as<std::string>() : "";
+				std::string cpu = result.count("mcpu") ? result["mcpu"].as<std::string>() : "";
+				std::string features = result.count("mattr") ? result["mattr"].as<std::string>() : "";
+				int splitParts = result.count("split") ? result["split"].as<int>() : 0;
+				std::string lto = result.count("flto") ? result["flto"].as<std::string>() : "";
+				build_project(projectName, threadCount, result["c"].as<std::string>(), optLevel, cpu, features, splitParts, lto, result.count("whole-program") > 0);
 			}
 			else if (command == "clean")
 			{
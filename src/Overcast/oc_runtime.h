@@ -0,0 +1,223 @@
+#pragma once
+// the C runtime every program links against, the build system writes it to obj/ and clang compiles it with the objects
+// print with a literal format calls the oc_write_* functions directly (see CGEngine::GenerateDirectPrint), other formats go through oc_printf
+#define OC_RUNTIME_SOURCE																															\
+"#include <stdarg.h>\n"																																\
+"#include <stdatomic.h>\n"																															\
+"#include <stdint.h>\n"																																\
+"#include <stdio.h>\n"																																\
+"#include <stdlib.h>\n"																																\
+"#include <string.h>\n"																																\
+"\n"																																				\
+"#ifdef _WIN32\n"																																	\
+"#include <windows.h>\n"																															\
+"#define OC_RELEASE_CALL WINAPI\n"																													\
+"#else\n"																																			\
+"#include <pthread.h>\n"																															\
+"#define OC_RELEASE_CALL\n"																															\
+"#endif\n"																																			\
+"\n"																																				\
+"#define OC_BUFFER_SIZE 65536 // a thread's output only goes to stdout once this much has piled up\n"												\
+"\n"																																				\
+"// every thread writes into its own buffer so print never takes a lock,\n"																			\
+"// a buffer goes out when its thread ends, and whatever's left in the others goes out at exit\n"													\
+"typedef struct oc_output\n"																														\
+"{\n"																																				\
+"\tstruct oc_output* prev;\n"																														\
+"\tstruct oc_output* next;\n"																														\
+"\tsize_t used;\n"																																	\
+"\tchar data[OC_BUFFER_SIZE];\n"																													\
+"} oc_output;\n"																																	\
+"\n"																																				\
+"static oc_output* oc_outputs_head;\n"																												\
+"static oc_output* oc_outputs_tail;\n"																												\
+"static atomic_flag oc_outputs_lock = ATOMIC_FLAG_INIT; // guards the list, only taken when a thread starts or stops printing and at exit\n"		\
+"static int oc_initialized;\n"																														\
+"static _Thread_local oc_output* oc_current;\n"																										\
+"\n"																																				\
+"#ifdef _WIN32\n"																																	\
+"static DWORD oc_thread_key = FLS_OUT_OF_INDEXES;\n"																								\
+"#else\n"																																			\
+"static pthread_key_t oc_thread_key;\n"																												\
+"#endif\n"																																			\
+"\n"																																				\
+"static void oc_lock(void)\n"																														\
+"{\n"																																				\
+"\twhile (atomic_flag_test_and_set_explicit(&oc_outputs_lock, memory_order_acquire))\n"																\
+"\t\t;\n"																																			\
+"}\n"																																				\
+"\n"																																				\
+"static void oc_unlock(void)\n"																														\
+"{\n"																																				\
+"\tatomic_flag_clear_explicit(&oc_outputs_lock, memory_order_release);\n"																			\
+"}\n"																																				\
+"\n"																																				\
+"static void oc_drain(oc_output* output)\n"																											\
+"{\n"																																				\
+"\tif (output->used)\n"																																\
+"\t\tfwrite(output->data, 1, output->used, stdout);\n"																								\
+"\toutput->used = 0;\n"																																\
+"}\n"																																				\
+"\n"																																				\
+"static void oc_drain_all(void)\n"																													\
+"{\n"																																				\
+"\t// oldest first, so the main thread's output comes before the threads it started\n"																\
+"\t// (a thread that's still running at exit can still race with this on its own buffer, same as it would with stdio's)\n"							\
+"\toc_lock();\n"																																	\
+"\tfor (oc_output* output = oc_outputs_head; output; output = output->next)\n"																		\
+"\t\toc_drain(output);\n"																															\
+"\toc_unlock();\n"																																	\
+"}\n"																																				\
+"\n"																																				\
+"// the thread-exit destructor, the buffer goes out and is given back\n"																			\
+"// it's only unlinked under the lock, the write can block and nobody else can reach the buffer after that\n"										\
+"static void OC_RELEASE_CALL oc_release(void* value)\n"																								\
+"{\n"																																				\
+"\toc_output* output = (oc_output*)value;\n"																										\
+"\tif (!output)\n"																																	\
+"\t\treturn;\n"																																		\
+"\n"																																				\
+"\toc_lock();\n"																																	\
+"\tif (output->prev)\n"																																\
+"\t\toutput->prev->next = output->next;\n"																											\
+"\telse\n"																																			\
+"\t\toc_outputs_head = output->next;\n"																												\
+"\tif (output->next)\n"																																\
+"\t\toutput->next->prev = output->prev;\n"																											\
+"\telse\n"																																			\
+"\t\toc_outputs_tail = output->prev;\n"																												\
+"\toc_unlock();\n"																																	\
+"\n"																																				\
+"\toc_drain(output);\n"																																\
+"\tif (oc_current == output)\n"																														\
+"\t\toc_current = NULL;\n"																															\
+"\tfree(output);\n"																																	\
+"}\n"																																				\
+"\n"																																				\
+"static oc_output* oc_get_output(void)\n"																											\
+"{\n"																																				\
+"\tif (oc_current)\n"																																\
+"\t\treturn oc_current;\n"																															\
+"\n"																																				\
+"\toc_output* output = (oc_output*)malloc(sizeof(oc_output));\n"																					\
+"\tif (!output)\n"																																	\
+"\t\tabort();\n"																																	\
+"\toutput->next = NULL;\n"																															\
+"\toutput->used = 0;\n"																																\
+"\n"																																				\
+"\toc_lock();\n"																																	\
+"\tif (!oc_initialized)\n"																															\
+"\t{\n"																																				\
+"\t\tatexit(oc_drain_all);\n"																														\
+"#ifdef _WIN32\n"																																	\
+"\t\toc_thread_key = FlsAlloc(oc_release);\n"																										\
+"#else\n"																																			\
+"\t\tpthread_key_create(&oc_thread_key, oc_release);\n"																								\
+"#endif\n"																																			\
+"\t\toc_initialized = 1;\n"																															\
+"\t}\n"																																				\
+"\n"																																				\
+"\toutput->prev = oc_outputs_tail;\n"																												\
+"\tif (oc_outputs_tail)\n"																															\
+"\t\toc_outputs_tail->next = output;\n"																												\
+"\telse\n"																																			\
+"\t\toc_outputs_head = output;\n"																													\
+"\toc_outputs_tail = output;\n"																														\
+"\toc_unlock();\n"																																	\
+"\n"																																				\
+"\t// the main thread doesn't run these when it returns from main, the atexit drain covers it\n"													\
+"#ifdef _WIN32\n"																																	\
+"\tif (oc_thread_key != FLS_OUT_OF_INDEXES)\n"																										\
+"\t\tFlsSetValue(oc_thread_key, output);\n"																											\
+"#else\n"																																			\
+"\tpthread_setspecific(oc_thread_key, output);\n"																									\
+"#endif\n"																																			\
+"\n"																																				\
+"\toc_current = output;\n"																															\
+"\treturn output;\n"																																\
+"}\n"																																				\
+"\n"																																				\
+"int32_t oc_write_bytes(const char* data, int64_t length)\n"																						\
+"{\n"																																				\
+"\toc_output* output = oc_get_output();\n"																											\
+"\tif (output->used + (size_t)length > OC_BUFFER_SIZE)\n"																							\
+"\t{\n"																																				\
+"\t\toc_drain(output);\n"																															\
+"\t\tif (length > OC_BUFFER_SIZE)\n"																												\
+"\t\t\treturn (int32_t)fwrite(data, 1, (size_t)length, stdout);\n"																					\
+"\t}\n"																																				\
+"\n"																																				\
+"\tmemcpy(output->data + output->used, data, (size_t)length);\n"																					\
+"\toutput->used += (size_t)length;\n"																												\
+"\treturn (int32_t)length;\n"																														\
+"}\n"																																				\
+"\n"																																				\
+"int32_t oc_write_str(const char* value)\n"																											\
+"{\n"																																				\
+"\treturn oc_write_bytes(value, (int64_t)strlen(value));\n"																							\
+"}\n"																																				\
+"\n"																																				\
+"int32_t oc_write_i32(int32_t value)\n"																												\
+"{\n"																																				\
+"\tchar digits[11];\n"																																\
+"\tint count = 0;\n"																																\
+"\tuint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;\n"																		\
+"\tdo\n"																																			\
+"\t{\n"																																				\
+"\t\tdigits[sizeof(digits) - 1 - count++] = (char)('0' + magnitude % 10);\n"																		\
+"\t\tmagnitude /= 10;\n"																															\
+"\t} while (magnitude);\n"																															\
+"\n"																																				\
+"\tif (value < 0)\n"																																\
+"\t\tdigits[sizeof(digits) - 1 - count++] = '-';\n"																									\
+"\treturn oc_write_bytes(digits + sizeof(digits) - count, count);\n"																				\
+"}\n"																																				\
+"\n"																																				\
+"// formats that weren't known at compile time, formatted straight into the buffer like everything else\n"											\
+"int32_t oc_printf(const char* format, ...)\n"																										\
+"{\n"																																				\
+"\toc_output* output = oc_get_output();\n"																											\
+"\tsize_t space = OC_BUFFER_SIZE - output->used;\n"																									\
+"\n"																																				\
+"\tva_list args;\n"																																	\
+"\tva_start(args, format);\n"																														\
+"\tint written = vsnprintf(output->data + output->used, space, format, args);\n"																	\
+"\tva_end(args);\n"																																	\
+"\n"																																				\
+"\tif (written < 0)\n"																																\
+"\t\treturn written;\n"																																\
+"\tif ((size_t)written < space)\n"																													\
+"\t{\n"																																				\
+"\t\toutput->used += (size_t)written;\n"																											\
+"\t\treturn written;\n"																																\
+"\t}\n"																																				\
+"\n"																																				\
+"\t// it didn't fit, so make room and format it again\n"																							\
+"\toc_drain(output);\n"																																\
+"\tva_start(args, format);\n"																														\
+"\tif ((size_t)written < OC_BUFFER_SIZE)\n"																											\
+"\t{\n"																																				\
+"\t\tvsnprintf(output->data, OC_BUFFER_SIZE, format, args);\n"																						\
+"\t\toutput->used = (size_t)written;\n"																												\
+"\t}\n"																																				\
+"\telse\n"																																			\
+"\t{\n"																																				\
+"\t\tchar* text = (char*)malloc((size_t)written + 1);\n"																							\
+"\t\tif (text)\n"																																	\
+"\t\t{\n"																																			\
+"\t\t\tvsnprintf(text, (size_t)written + 1, format, args);\n"																						\
+"\t\t\tfwrite(text, 1, (size_t)written, stdout);\n"																									\
+"\t\t\tfree(text);\n"																																\
+"\t\t}\n"																																			\
+"\t}\n"																																				\
+"\tva_end(args);\n"																																	\
+"\treturn written;\n"																																\
+"}\n"																																				\
+"\n"																																				\
+"// the flush() builtin, only the calling thread's output goes out\n"																				\
+"void oc_flush(void)\n"																																\
+"{\n"																																				\
+"\toc_drain(oc_get_output());\n"																													\
+"\tfflush(stdout);\n"																																\
+"}\n"																																				\
+